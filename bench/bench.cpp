@@ -0,0 +1,121 @@
+/* Headless benchmark of the module DSP.
+   Builds the module sources against the Rack stub in bench/stub and drives
+   process() for every case, prints ns/sample and instructions/sample as JSON.
+
+   make bench BENCH_ARGS="[samples] [filter]"
+
+   The stub stands in for the Rack SDK, absolute numbers differ from a real
+   Rack build, use them to compare builds on the same machine.
+*/
+#include "cases.hpp"
+
+#include <chrono>
+#include <cstdio>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/** Retired instructions of the calling thread, from perf_event_open.
+    Not available everywhere, then valid() is false.
+*/
+struct InstructionCounter {
+  int fd = -1;
+
+  InstructionCounter() {
+#ifdef __linux__
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+  }
+
+  ~InstructionCounter() {
+#ifdef __linux__
+    if (fd >= 0) {
+      close(fd);
+    }
+#endif
+  }
+
+  bool valid() {
+    return fd >= 0;
+  }
+
+  void start() {
+#ifdef __linux__
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+  }
+
+  long long stop() {
+    long long count = 0;
+#ifdef __linux__
+    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    if (read(fd, &count, sizeof(count)) != sizeof(count)) {
+      count = 0;
+    }
+#endif
+    return count;
+  }
+};
+
+
+int main(int argc, char** argv) {
+  long samples = (argc > 1) ? std::atol(argv[1]) : 1000000;
+  std::string filter = (argc > 2) ? argv[2] : "";
+  samples = std::max<long>(blockSize, samples / blockSize * blockSize);
+
+  Window window;
+  Engine engine;
+  App app{&window, &engine};
+  appInstance = &app;
+  Module::ProcessArgs args{engine.sampleRate, 1.f / engine.sampleRate};
+
+  std::vector<Case> cases = allCases(filter);
+
+  InstructionCounter counter;
+  std::printf("{\n  \"sampleRate\": %g,\n  \"samples\": %ld,\n  \"results\": [", args.sampleRate, samples);
+  for (size_t i = 0; i < cases.size(); i++) {
+    const Case& c = cases[i];
+    Module* m = c.create();
+    c.setup(m);
+    // Warm up, lets the coefficient caches and tables settle.
+    run(m, c, samples / 10, args);
+
+    long long instructions = 0;
+    if (counter.valid()) {
+      counter.start();
+    }
+    auto start = std::chrono::steady_clock::now();
+    run(m, c, samples, args);
+    auto end = std::chrono::steady_clock::now();
+    if (counter.valid()) {
+      instructions = counter.stop();
+    }
+    delete m;
+
+    double ns = std::chrono::duration<double, std::nano>(end - start).count() / samples;
+    std::printf("%s\n    {\"module\": \"%s\", \"case\": \"%s\", \"nsPerSample\": %.3f, \"instructionsPerSample\": ",
+      i ? "," : "", c.module.c_str(), c.name.c_str(), ns);
+    if (counter.valid()) {
+      std::printf("%.1f}", (double) instructions / samples);
+    }
+    else {
+      std::printf("null}");
+    }
+    std::fflush(stdout);
+  }
+  std::printf("\n  ]\n}\n");
+  return 0;
+}
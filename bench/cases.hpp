@@ -0,0 +1,478 @@
+/* Benchmark and golden-output cases, shared by bench.cpp and golden.cpp.
+   Includes the module sources directly so the cases can use the module
+   enums, include once per program.
+*/
+#pragma once
+#include "../src/plugin.cpp"
+#include "../src/Bezosc.cpp"
+#include "../src/rndbezosc.cpp"
+#include "../src/Ramp.cpp"
+
+#include <functional>
+
+namespace rack {
+App* appInstance;
+std::vector<Model*>& plugin::registry() {
+  static std::vector<Model*> models;
+  return models;
+}
+}
+
+/** One benchmark case. setup() connects ports and sets params, tick() is
+    called every block, for gates and triggers.
+*/
+struct Case {
+  std::string module;
+  std::string name;
+  std::function<Module*()> create;
+  std::function<void(Module*)> setup;
+  std::function<void(Module*, long)> tick;
+};
+
+static const int blockSize = 64;
+
+static std::vector<Case> bezoscCases() {
+  struct PortSet {
+    const char* name;
+    std::vector<int> outputs;
+  };
+  const PortSet sets[] = {
+    {"x", {Bezosc::OBEZX_OUTPUT}},
+    {"xy", {Bezosc::OBEZX_OUTPUT, Bezosc::OBEZY_OUTPUT}},
+    {"position", {Bezosc::OBEZX_OUTPUT, Bezosc::OBEZY_OUTPUT, Bezosc::OBEZTH_OUTPUT, Bezosc::OBEZL_OUTPUT}},
+    {"tangent", {Bezosc::OTANX_OUTPUT, Bezosc::OTANY_OUTPUT, Bezosc::OTANTH_OUTPUT, Bezosc::OTANL_OUTPUT}},
+    {"all", {
+      Bezosc::OBEZX_OUTPUT, Bezosc::OBEZY_OUTPUT, Bezosc::OBEZTH_OUTPUT, Bezosc::OBEZL_OUTPUT,
+      Bezosc::OTANX_OUTPUT, Bezosc::OTANY_OUTPUT, Bezosc::OTANTH_OUTPUT, Bezosc::OTANL_OUTPUT
+    }},
+  };
+  std::vector<Case> cases;
+  for (int modus = 1; modus <= 4; modus++) {
+    for (const PortSet& set : sets) {
+      std::vector<int> outputs = set.outputs;
+      Case c;
+      c.module = "Bezosc";
+      c.name = "modus " + std::to_string(modus) + ", " + set.name;
+      c.create = [] { return new Bezosc; };
+      c.setup = [=](Module* m) {
+        m->params[Bezosc::MODUS_PARAM].setValue(modus);
+        m->params[Bezosc::PBEZFREQ_PARAM].setValue(0.5f);
+        for (int id : outputs) {
+          m->outputs[id].channels = 1;
+        }
+      };
+      cases.push_back(c);
+    }
+    // 16 voices, all outputs.
+    Case c;
+    c.module = "Bezosc";
+    c.name = "modus " + std::to_string(modus) + ", all, 16 voices";
+    c.create = [] { return new Bezosc; };
+    c.setup = [=](Module* m) {
+      m->params[Bezosc::MODUS_PARAM].setValue(modus);
+      Input& freq = m->inputs[Bezosc::IBEZFREQ_INPUT];
+      freq.channels = 16;
+      for (int ch = 0; ch < 16; ch++) {
+        freq.voltages[ch] = ch / 12.f;
+      }
+      for (int i = 0; i < Bezosc::NUM_OUTPUTS; i++) {
+        m->outputs[i].channels = 1;
+      }
+    };
+    cases.push_back(c);
+  }
+  // Context menu options, modus 4 with all outputs.
+  struct Option {
+    const char* name;
+    const char* key;
+    json_t* (*value)();
+  };
+  const Option options[] = {
+    {"oversample 2", "oversample", [] { return json_integer(2); }},
+    {"oversample 4", "oversample", [] { return json_integer(4); }},
+    {"oversample 8", "oversample", [] { return json_integer(8); }},
+    {"oversample 16, plays 1x", "oversample", [] { return json_integer(16); }},
+    {"fast theta and length", "fast", [] { return json_true(); }},
+    {"constant speed", "arcLength", [] { return json_true(); }},
+  };
+  for (const Option& option : options) {
+    Case c;
+    c.module = "Bezosc";
+    c.name = std::string("modus 4, all, ") + option.name;
+    c.create = [] { return new Bezosc; };
+    c.setup = [=](Module* m) {
+      json_t* rootJ = json_object();
+      json_object_set_new(rootJ, option.key, option.value());
+      m->dataFromJson(rootJ);
+      json_decref(rootJ);
+      m->params[Bezosc::MODUS_PARAM].setValue(4);
+      m->params[Bezosc::PBEZFREQ_PARAM].setValue(0.5f);
+      for (int i = 0; i < Bezosc::NUM_OUTPUTS; i++) {
+        m->outputs[i].channels = 1;
+      }
+    };
+    cases.push_back(c);
+  }
+  // 4x oversampling with one output, the decimator share is smallest.
+  {
+    Case c;
+    c.module = "Bezosc";
+    c.name = "modus 4, x, oversample 4";
+    c.create = [] { return new Bezosc; };
+    c.setup = [](Module* m) {
+      json_t* rootJ = json_object();
+      json_object_set_new(rootJ, "oversample", json_integer(4));
+      m->dataFromJson(rootJ);
+      json_decref(rootJ);
+      m->params[Bezosc::MODUS_PARAM].setValue(4);
+      m->params[Bezosc::PBEZFREQ_PARAM].setValue(0.5f);
+      m->outputs[Bezosc::OBEZX_OUTPUT].channels = 1;
+    };
+    cases.push_back(c);
+  }
+  // The whole shape modulated, over the 24 jacks and over the shape bus.
+  for (bool bus : {false, true}) {
+    Case c;
+    c.module = "Bezosc";
+    c.name = bus ? "modus 4, all, shape bus" : "modus 4, all, 24 inputs";
+    c.create = [] { return new Bezosc; };
+    c.setup = [=](Module* m) {
+      m->params[Bezosc::MODUS_PARAM].setValue(4);
+      m->params[Bezosc::PBEZFREQ_PARAM].setValue(0.5f);
+      for (int i = 0; i < Bezosc::NUM_OUTPUTS; i++) {
+        m->outputs[i].channels = 1;
+      }
+      if (bus) {
+        m->inputs[Bezosc::BUSA_INPUT].channels = 16;
+        m->inputs[Bezosc::BUSB_INPUT].channels = 8;
+      }
+      else {
+        for (int i = 0; i < Bezosc::numXY; i++) {
+          m->inputs[Bezosc::IBEZ_INPUT + i].channels = 1;
+        }
+      }
+    };
+    c.tick = [=](Module* m, long n) {
+      for (int i = 0; i < Bezosc::numXY; i++) {
+        float v = 0.5f * std::sin(1e-4f * n * (i + 1));
+        if (!bus) {
+          m->inputs[Bezosc::IBEZ_INPUT + i].voltages[0] = v;
+        }
+        else if (i < 16) {
+          m->inputs[Bezosc::BUSA_INPUT].voltages[i] = v;
+        }
+        else {
+          m->inputs[Bezosc::BUSB_INPUT].voltages[i - 16] = v;
+        }
+      }
+    };
+    cases.push_back(c);
+  }
+  // Spline from the module on the left, a new one every block. The left
+  // neighbour is a bare module, tick() writes its message.
+  Case c;
+  c.module = "Bezosc";
+  c.name = "follow left, all";
+  c.create = [] {
+    Bezosc* m = new Bezosc;
+    Module* left = new Module;
+    left->model = modelRndbezosc;
+    m->leftExpander.module = left;
+    m->leftExpander.moduleId = 1;
+    m->followLeft = true;
+    return m;
+  };
+  c.setup = [](Module* m) {
+    m->params[Bezosc::PBEZFREQ_PARAM].setValue(0.5f);
+    for (int i = 0; i < Bezosc::NUM_OUTPUTS; i++) {
+      m->outputs[i].channels = 1;
+    }
+  };
+  c.tick = [](Module* m, long n) {
+    SplineMessage* message = (SplineMessage*) m->leftExpander.consumerMessage;
+    for (int s = 0; s < SplineMessage::numSegments; s++) {
+      for (int j = 0; j < SplineMessage::pointsSegment; j++) {
+        float a = 2.f * M_PI * (s + j / 3.f) / SplineMessage::numSegments;
+        float r = 4.f + std::sin(1e-4f * n * (4 * s + j + 1));
+        message->x[s][j] = r * std::cos(a);
+        message->y[s][j] = r * std::sin(a);
+      }
+    }
+    message->serial = n / blockSize + 1;
+  };
+  cases.push_back(c);
+  return cases;
+}
+
+/** Fixed seed, the same random targets on every run. */
+static void seedRndbezosc(Module* m) {
+  json_t* rootJ = json_object();
+  json_object_set_new(rootJ, "seed", json_integer(1));
+  m->dataFromJson(rootJ);
+  json_decref(rootJ);
+}
+
+static std::vector<Case> rndbezoscCases() {
+  std::vector<Case> cases;
+  for (int style = 0; style <= 2; style++) {
+    Case c;
+    c.module = "Rndbezosc";
+    c.name = "style " + std::to_string(style);
+    c.create = [] { return new Rndbezosc; };
+    c.setup = [=](Module* m) {
+      seedRndbezosc(m);
+      m->params[Rndbezosc::STYLE_PARAM].setValue(style);
+      m->outputs[Rndbezosc::OUT_OUTPUT].channels = 1;
+    };
+    cases.push_back(c);
+  }
+  Case c;
+  c.module = "Rndbezosc";
+  c.name = "style 0, 16 voices";
+  c.create = [] { return new Rndbezosc; };
+  c.setup = [](Module* m) {
+    seedRndbezosc(m);
+    Input& freq = m->inputs[Rndbezosc::IFREQ_INPUT];
+    freq.channels = 16;
+    for (int ch = 0; ch < 16; ch++) {
+      freq.voltages[ch] = ch / 12.f;
+    }
+    m->outputs[Rndbezosc::OUT_OUTPUT].channels = 1;
+  };
+  cases.push_back(c);
+  c.name = "style 2, ADAA";
+  c.setup = [](Module* m) {
+    seedRndbezosc(m);
+    static_cast<Rndbezosc*>(m)->adaa = true;
+    m->params[Rndbezosc::STYLE_PARAM].setValue(2.f);
+    m->params[Rndbezosc::PFREQ_PARAM].setValue(2.f);
+    m->outputs[Rndbezosc::OUT_OUTPUT].channels = 1;
+  };
+  cases.push_back(c);
+  // An LFO and a voice past a segment per sample take the midpoint
+  // fallback, the two voices between the ADAA.
+  c.name = "style 2, ADAA, 4 voices";
+  c.setup = [](Module* m) {
+    seedRndbezosc(m);
+    static_cast<Rndbezosc*>(m)->adaa = true;
+    m->params[Rndbezosc::STYLE_PARAM].setValue(2.f);
+    m->params[Rndbezosc::PFREQ_PARAM].setValue(2.f);
+    Input& freq = m->inputs[Rndbezosc::IFREQ_INPUT];
+    freq.channels = 4;
+    const float pitches[4] = {-8.f, -2.f, 3.f, 4.5f};
+    for (int ch = 0; ch < 4; ch++) {
+      freq.voltages[ch] = pitches[ch];
+    }
+    m->outputs[Rndbezosc::OUT_OUTPUT].channels = 1;
+  };
+  cases.push_back(c);
+  for (int segments = 2; segments <= 16; segments *= 2) {
+    if (segments == 4) {
+      continue;
+    }
+    c.name = "style 0, " + std::to_string(segments) + " segments";
+    c.setup = [=](Module* m) {
+      seedRndbezosc(m);
+      static_cast<Rndbezosc*>(m)->pendingSegments = segments;
+      m->outputs[Rndbezosc::OUT_OUTPUT].channels = 1;
+    };
+    cases.push_back(c);
+  }
+  return cases;
+}
+
+static std::vector<Case> rampCases() {
+  struct PortSet {
+    const char* name;
+    std::vector<int> outputs;
+    int channels;
+    // Time of row i is timeStep * (i + 1).
+    float timeStep;
+  };
+  std::vector<PortSet> sets(4);
+  sets[0].name = "unipolar";
+  sets[0].channels = 1;
+  sets[0].timeStep = 0.05f;
+  sets[1].name = "all";
+  sets[1].channels = 1;
+  sets[1].timeStep = 0.05f;
+  sets[2].name = "all, 16 channels";
+  sets[2].channels = 16;
+  sets[2].timeStep = 0.05f;
+  // Mostly idle, the ramps run for 2 to 16 ms of every 16384 samples.
+  sets[3].name = "all, 16 channels, short";
+  sets[3].channels = 16;
+  sets[3].timeStep = 0.002f;
+  for (int i = 0; i < 8; i++) {
+    sets[0].outputs.push_back(Ramp::VOUTU_OUTPUT + i);
+    for (int j = 1; j < 4; j++) {
+      sets[j].outputs.push_back(Ramp::VOUTU_OUTPUT + i);
+      sets[j].outputs.push_back(Ramp::VOUTB_OUTPUT + i);
+      sets[j].outputs.push_back(Ramp::END_OUTPUT + i);
+    }
+  }
+  // The last one is the Bezier curve, an S-curve with overshoot.
+  const float interps[] = {0.f, 0.5f, 1.f, 5.f, 10.f, -1.f};
+  std::vector<Case> cases;
+  for (float interp : interps) {
+    bool bezier = interp < 0.f;
+    for (const PortSet& set : sets) {
+      std::vector<int> outputs = set.outputs;
+      int channels = set.channels;
+      float timeStep = set.timeStep;
+      Case c;
+      c.module = "Ramp";
+      char name[64];
+      if (bezier) {
+        std::snprintf(name, sizeof(name), "bezier, %s", set.name);
+      }
+      else {
+        std::snprintf(name, sizeof(name), "interp %g, %s", interp, set.name);
+      }
+      c.name = name;
+      c.create = [] { return new Ramp; };
+      c.setup = [=](Module* m) {
+        for (int i = 0; i < 8; i++) {
+          m->params[Ramp::VFROM_PARAM + i].setValue(0.f);
+          m->params[Ramp::VTO_PARAM + i].setValue(10.f);
+          m->params[Ramp::TIME_PARAM + i].setValue(timeStep * (i + 1));
+          m->params[Ramp::INTERP_PARAM + i].setValue(bezier ? 0.f : interp);
+          m->params[Ramp::HANDLE1_PARAM + i].setValue(0.f);
+          m->params[Ramp::HANDLE2_PARAM + i].setValue(1.2f);
+          ((Ramp*) m)->bezierRow[i] = bezier;
+          m->inputs[Ramp::START_INPUT + i].channels = channels;
+        }
+        for (int id : outputs) {
+          m->outputs[id].channels = 1;
+        }
+      };
+      // Retrigger all rows every 16384 samples, the rows end at different
+      // times, channel ch one block after channel ch - 1.
+      c.tick = [=](Module* m, long n) {
+        for (int ch = 0; ch < channels; ch++) {
+          long t = (n - ch * blockSize) % 16384;
+          float v = (t >= 0 && t < blockSize) ? 10.f : 0.f;
+          for (int i = 0; i < 8; i++) {
+            m->inputs[Ramp::START_INPUT + i].voltages[ch] = v;
+          }
+        }
+      };
+      cases.push_back(c);
+    }
+  }
+  // Chain mode, an ADSR with a looping tail per channel, gates of
+  // different lengths.
+  for (int channels : {1, 16}) {
+    Case c;
+    c.module = "Ramp";
+    c.name = (channels == 1) ? "chain, mono" : "chain, 16 channels";
+    c.create = [] { return new Ramp; };
+    c.setup = [=](Module* m) {
+      Ramp* r = (Ramp*) m;
+      r->chainRequested = true;
+      r->sustainStage = 1;
+      r->loopStage = 3;
+      const float tos[8] = {10.f, 6.f, 0.f, 2.f, 0.f, 0.f, 0.f, 0.f};
+      const float times[8] = {0.005f, 0.02f, 0.05f, 0.01f, 0.01f, 0.f, 0.f, 0.f};
+      const float interps[8] = {0.f, 5.f, 0.5f, 1.f, 1.f, 1.f, 1.f, 1.f};
+      for (int i = 0; i < 8; i++) {
+        m->params[Ramp::VTO_PARAM + i].setValue(tos[i]);
+        m->params[Ramp::TIME_PARAM + i].setValue(times[i]);
+        m->params[Ramp::INTERP_PARAM + i].setValue(interps[i]);
+        m->outputs[Ramp::END_OUTPUT + i].channels = 1;
+      }
+      m->inputs[Ramp::START_INPUT].channels = channels;
+      m->outputs[Ramp::VOUTU_OUTPUT].channels = 1;
+      m->outputs[Ramp::VOUTB_OUTPUT].channels = 1;
+    };
+    // Gate every 8192 samples, channel ch held for (ch + 1) * 256 samples.
+    c.tick = [=](Module* m, long n) {
+      for (int ch = 0; ch < channels; ch++) {
+        long t = n % 8192;
+        m->inputs[Ramp::START_INPUT].voltages[ch] = (t >= blockSize && t < (ch + 1) * 256 + blockSize) ? 10.f : 0.f;
+      }
+    };
+    cases.push_back(c);
+  }
+  // Idle, every row patched and never started, the cost of watching the
+  // start and stop inputs.
+  for (int channels : {1, 16}) {
+    Case c;
+    c.module = "Ramp";
+    c.name = (channels == 1) ? "idle, mono" : "idle, 16 channels";
+    c.create = [] { return new Ramp; };
+    c.setup = [=](Module* m) {
+      for (int i = 0; i < 8; i++) {
+        m->inputs[Ramp::START_INPUT + i].channels = channels;
+        m->inputs[Ramp::STOP_INPUT + i].channels = channels;
+        m->outputs[Ramp::VOUTU_OUTPUT + i].channels = 1;
+        m->outputs[Ramp::VOUTB_OUTPUT + i].channels = 1;
+        m->outputs[Ramp::END_OUTPUT + i].channels = 1;
+      }
+    };
+    cases.push_back(c);
+  }
+  // Every CV patched with 16 channels and moving, the rows retriggered
+  // like the interp cases, the cost of following the CVs on every sample.
+  {
+    Case c;
+    c.module = "Ramp";
+    c.name = "cv, 16 channels";
+    c.create = [] { return new Ramp; };
+    c.setup = [](Module* m) {
+      for (int i = 0; i < 8; i++) {
+        m->inputs[Ramp::START_INPUT + i].channels = 16;
+        m->outputs[Ramp::VOUTU_OUTPUT + i].channels = 1;
+        m->outputs[Ramp::VOUTB_OUTPUT + i].channels = 1;
+        m->outputs[Ramp::END_OUTPUT + i].channels = 1;
+      }
+      for (int id = Ramp::FROM_CV_INPUT; id <= Ramp::INTERP_CV_INPUT; id++) {
+        m->inputs[id].channels = 16;
+      }
+    };
+    // From and To drift per channel, the time between about 40 and 130
+    // ms, the interpolation steps through cosine, ease in, linear and
+    // ease out every 4096 samples.
+    c.tick = [](Module* m, long n) {
+      const float interps[4] = {0.f, 0.5f, 1.f, 5.f};
+      for (int ch = 0; ch < 16; ch++) {
+        float phase = (float) n / 16384.f + ch / 16.f;
+        m->inputs[Ramp::FROM_CV_INPUT].voltages[ch] = 2.f + 2.f * std::sin(2.f * float(M_PI) * phase);
+        m->inputs[Ramp::TO_CV_INPUT].voltages[ch] = 8.f + 2.f * std::cos(2.f * float(M_PI) * phase);
+        m->inputs[Ramp::TIME_CV_INPUT].voltages[ch] = 0.1f + 0.05f * std::sin(2.f * float(M_PI) * 3.f * phase);
+        m->inputs[Ramp::INTERP_CV_INPUT].voltages[ch] = interps[(n / 4096 + ch) % 4];
+        long t = (n - ch * blockSize) % 16384;
+        float v = (t >= 0 && t < blockSize) ? 10.f : 0.f;
+        for (int i = 0; i < 8; i++) {
+          m->inputs[Ramp::START_INPUT + i].voltages[ch] = v;
+        }
+      }
+    };
+    cases.push_back(c);
+  }
+  return cases;
+}
+
+static void run(Module* m, const Case& c, long samples, const Module::ProcessArgs& args) {
+  for (long n = 0; n < samples; n += blockSize) {
+    if (c.tick) {
+      c.tick(m, n);
+    }
+    for (int k = 0; k < blockSize; k++) {
+      m->process(args);
+    }
+  }
+}
+
+/** All cases whose "module name" contains filter. */
+static std::vector<Case> allCases(const std::string& filter) {
+  std::vector<Case> cases;
+  for (auto list : {bezoscCases(), rndbezoscCases(), rampCases()}) {
+    for (const Case& c : list) {
+      if ((c.module + " " + c.name).find(filter) != std::string::npos) {
+        cases.push_back(c);
+      }
+    }
+  }
+  return cases;
+}
@@ -0,0 +1,432 @@
+/* Golden-output regression check of the module DSP.
+   Renders a fixed number of samples of every connected output for every
+   case in cases.hpp and records a compact reference of them, or compares
+   the render to the recorded reference by max. abs. error per sample and
+   by spectral error.
+
+   make golden-record                 record from a trusted build
+   make golden GOLDEN_ARGS="[maxAbs] [spectralDb] [filter]"
+
+   The references in bench/reference are committed, a change that alters
+   the output on purpose records the cases it alters with it. They hold
+   every sample of every channel, rounded to quantum and coded as the
+   residuals of a linear prediction. Rndbezosc is seeded per case.
+*/
+#include "cases.hpp"
+
+#include <cctype>
+#include <climits>
+#include <complex>
+#include <cstdio>
+
+static const int frames = 16384;
+// A case wider than wideChannels keeps only the first frames of its
+// render that fit frames * wideChannels samples, at least minFrames,
+// so the 16 voice and 16 channel cases stay small.
+static const int wideChannels = 32;
+static const int minFrames = 4096;
+// References are stored in steps of 1/32768 V, a thirtieth of the
+// default max. abs. error.
+static const double quantum = 1.0 / 32768;
+static const int spectrumFrames = 1024;
+
+/** Interleaved render of all connected output channels. */
+struct Render {
+  int channels = 0;
+  std::vector<float> data;
+};
+
+/** The samples of a render, [channel][frame], in steps of quantum. */
+struct Reference {
+  int channels = 0;
+  int frames = 0;
+  std::vector<float> samples;
+};
+
+static int keptFrames(int channels) {
+  return (channels <= wideChannels) ? frames : std::max(minFrames, frames / channels * wideChannels);
+}
+
+static Reference reduce(const Render& r) {
+  Reference ref;
+  ref.channels = r.channels;
+  ref.frames = keptFrames(r.channels);
+  ref.samples.resize((size_t) ref.channels * ref.frames);
+  for (int ch = 0; ch < ref.channels; ch++) {
+    for (int i = 0; i < ref.frames; i++) {
+      double x = r.data[(size_t) i * r.channels + ch];
+      ref.samples[(size_t) ch * ref.frames + i] = std::round(x / quantum) * quantum;
+    }
+  }
+  return ref;
+}
+
+static Render render(const Case& c, const Module::ProcessArgs& args) {
+  Module* m = c.create();
+  c.setup(m);
+  std::vector<std::pair<int, int>> ports;
+  Render r;
+  for (long n = 0; n < frames; n += blockSize) {
+    if (c.tick) {
+      c.tick(m, n);
+    }
+    for (int k = 0; k < blockSize; k++) {
+      m->process(args);
+      if (n == 0 && k == 0) {
+        // The channel count is only known after the first process().
+        for (int i = 0; i < (int) m->outputs.size(); i++) {
+          for (int ch = 0; ch < m->outputs[i].getChannels(); ch++) {
+            ports.push_back(std::make_pair(i, ch));
+          }
+        }
+        r.channels = ports.size();
+      }
+      for (const auto& p : ports) {
+        r.data.push_back(m->outputs[p.first].voltages[p.second]);
+      }
+    }
+  }
+  delete m;
+  return r;
+}
+
+static std::string slug(const Case& c) {
+  std::string s = c.module + "-" + c.name;
+  std::string out;
+  for (char ch : s) {
+    if (std::isalnum((unsigned char) ch)) {
+      out += std::tolower((unsigned char) ch);
+    }
+    else if (ch == '.') {
+      out += '_';
+    }
+    else if (!out.empty() && out.back() != '-') {
+      out += '-';
+    }
+  }
+  return out;
+}
+
+struct BitWriter {
+  std::vector<uint8_t> bytes;
+  int used = 8;
+
+  void put(uint64_t v, int bits) {
+    for (int b = bits - 1; b >= 0; b--) {
+      if (used == 8) {
+        bytes.push_back(0);
+        used = 0;
+      }
+      bytes.back() |= ((v >> b) & 1) << (7 - used);
+      used++;
+    }
+  }
+};
+
+struct BitReader {
+  const std::vector<uint8_t>& bytes;
+  size_t pos = 0;
+
+  BitReader(const std::vector<uint8_t>& bytes) : bytes(bytes) {}
+
+  bool get(int bits, uint64_t& v) {
+    v = 0;
+    for (int b = 0; b < bits; b++, pos++) {
+      if (pos >= bytes.size() * 8) {
+        return false;
+      }
+      v = (v << 1) | ((bytes[pos / 8] >> (7 - pos % 8)) & 1);
+    }
+    return true;
+  }
+};
+
+// Rice coding of the residuals per block of riceBlock samples, with the
+// parameter that codes the block shortest in riceParamBits, all ones
+// for a block of zero residuals. A quotient of riceEscape ones is
+// followed by the residual in riceRawBits.
+static const int riceBlock = 64;
+static const int riceParamBits = 5;
+static const int riceZeros = (1 << riceParamBits) - 1;
+static const int riceEscape = 16;
+static const int riceRawBits = 48;
+
+static int riceBits(uint64_t zz, int k) {
+  uint64_t q = zz >> k;
+  return q < riceEscape ? q + 1 + k : riceEscape + riceRawBits;
+}
+
+/** A channel as the residuals of a linear prediction from the last two
+    samples, in quanta, zigzag and Rice coded. Holds and silence take
+    a few bits a block, smooth ramps about two bits a sample, where
+    rounding to quantum dithers the residuals.
+*/
+static std::vector<uint8_t> encode(const float* x, int length) {
+  BitWriter w;
+  int64_t q1 = 0;
+  int64_t q2 = 0;
+  uint64_t zz[riceBlock];
+  for (int i = 0; i < length; i += riceBlock) {
+    uint64_t any = 0;
+    for (int j = 0; j < riceBlock; j++) {
+      // A NaN is recorded as 1000 V, the check fails on it anyway.
+      int64_t q = std::llround(clamp(x[i + j], -1000.f, 1000.f) / quantum);
+      int64_t residual = q - (2 * q1 - q2);
+      q2 = q1;
+      q1 = q;
+      zz[j] = residual < 0 ? 2 * (uint64_t) -residual - 1 : 2 * (uint64_t) residual;
+      any |= zz[j];
+    }
+    if (!any) {
+      w.put(riceZeros, riceParamBits);
+      continue;
+    }
+    int best = 0;
+    long bestBits = LONG_MAX;
+    for (int k = 0; k < riceZeros; k++) {
+      long bits = 0;
+      for (int j = 0; j < riceBlock; j++) {
+        bits += riceBits(zz[j], k);
+      }
+      if (bits < bestBits) {
+        best = k;
+        bestBits = bits;
+      }
+    }
+    w.put(best, riceParamBits);
+    for (int j = 0; j < riceBlock; j++) {
+      uint64_t q = zz[j] >> best;
+      if (q < riceEscape) {
+        w.put(((uint64_t) 1 << (q + 1)) - 2, q + 1);
+        w.put(zz[j], best);
+      }
+      else {
+        w.put(((uint64_t) 1 << riceEscape) - 1, riceEscape);
+        w.put(zz[j], riceRawBits);
+      }
+    }
+  }
+  return w.bytes;
+}
+
+static bool decode(const std::vector<uint8_t>& bytes, float* x, int length) {
+  BitReader r(bytes);
+  int64_t q1 = 0;
+  int64_t q2 = 0;
+  for (int i = 0; i < length; i += riceBlock) {
+    uint64_t k;
+    if (!r.get(riceParamBits, k)) {
+      return false;
+    }
+    for (int j = 0; j < riceBlock; j++) {
+      uint64_t zz = 0;
+      if (k != riceZeros) {
+        uint64_t q = 0;
+        uint64_t bit;
+        while (q < riceEscape && r.get(1, bit) && bit) {
+          q++;
+        }
+        if (!r.get(q < riceEscape ? k : riceRawBits, zz)) {
+          return false;
+        }
+        if (q < riceEscape) {
+          zz |= q << k;
+        }
+      }
+      int64_t residual = (zz & 1) ? -(int64_t) ((zz + 1) / 2) : (int64_t) (zz / 2);
+      int64_t q = 2 * q1 - q2 + residual;
+      q2 = q1;
+      q1 = q;
+      x[i + j] = q * quantum;
+    }
+  }
+  return true;
+}
+
+static bool save(const std::string& path, const Reference& r) {
+  FILE* f = std::fopen(path.c_str(), "wb");
+  if (!f) {
+    return false;
+  }
+  int header[2] = {r.frames, r.channels};
+  std::fwrite(header, sizeof(int), 2, f);
+  for (int ch = 0; ch < r.channels; ch++) {
+    std::vector<uint8_t> bytes = encode(&r.samples[(size_t) ch * r.frames], r.frames);
+    uint32_t size = bytes.size();
+    std::fwrite(&size, sizeof(size), 1, f);
+    std::fwrite(bytes.data(), 1, bytes.size(), f);
+  }
+  std::fclose(f);
+  return true;
+}
+
+static bool load(const std::string& path, Reference& r) {
+  FILE* f = std::fopen(path.c_str(), "rb");
+  if (!f) {
+    return false;
+  }
+  int header[2];
+  bool ok = (
+       std::fread(header, sizeof(int), 2, f) == 2
+    && header[1] >= 0 && header[0] == keptFrames(header[1])
+  );
+  if (ok) {
+    r.channels = header[1];
+    r.frames = header[0];
+    r.samples.resize((size_t) r.channels * r.frames);
+  }
+  for (int ch = 0; ok && ch < r.channels; ch++) {
+    uint32_t size;
+    ok = std::fread(&size, sizeof(size), 1, f) == 1;
+    std::vector<uint8_t> bytes(ok ? size : 0);
+    ok = ok && std::fread(bytes.data(), 1, bytes.size(), f) == bytes.size();
+    ok = ok && decode(bytes, &r.samples[(size_t) ch * r.frames], r.frames);
+  }
+  std::fclose(f);
+  return ok;
+}
+
+/** In place radix-2 FFT, size a power of 2. */
+static void fft(std::vector<std::complex<double>>& x) {
+  size_t n = x.size();
+  for (size_t i = 1, j = 0; i < n; i++) {
+    size_t bit = n >> 1;
+    for (; j & bit; bit >>= 1) {
+      j ^= bit;
+    }
+    j ^= bit;
+    if (i < j) {
+      std::swap(x[i], x[j]);
+    }
+  }
+  for (size_t len = 2; len <= n; len <<= 1) {
+    std::complex<double> w = std::polar(1.0, -2.0 * M_PI / len);
+    for (size_t i = 0; i < n; i += len) {
+      std::complex<double> wk = 1.0;
+      for (size_t k = 0; k < len / 2; k++) {
+        std::complex<double> a = x[i + k];
+        std::complex<double> b = x[i + k + len / 2] * wk;
+        x[i + k] = a + b;
+        x[i + k + len / 2] = a - b;
+        wk *= w;
+      }
+    }
+  }
+}
+
+/** Hann windowed magnitude spectrum of spectrumFrames samples. */
+static std::vector<double> magnitudes(const float* x) {
+  std::vector<std::complex<double>> c(spectrumFrames);
+  for (int i = 0; i < spectrumFrames; i++) {
+    double w = 0.5 - 0.5 * std::cos(2.0 * M_PI * i / spectrumFrames);
+    c[i] = w * x[i];
+  }
+  fft(c);
+  std::vector<double> mag(spectrumFrames / 2 + 1);
+  for (size_t k = 0; k < mag.size(); k++) {
+    mag[k] = std::abs(c[k]);
+  }
+  return mag;
+}
+
+/** Magnitude spectrum difference relative to the reference spectrum, in
+    dB, of the worst channel. Every channel is windowed over the whole
+    render, half overlapping, so every ramp and morph is seen.
+    Insensitive to small phase shifts.
+*/
+static double spectralError(const Reference& ref, const Reference& out) {
+  double worst = -INFINITY;
+  for (int ch = 0; ch < ref.channels; ch++) {
+    const float* a = &ref.samples[(size_t) ch * ref.frames];
+    const float* b = &out.samples[(size_t) ch * ref.frames];
+    if (std::equal(a, a + ref.frames, b)) {
+      continue;
+    }
+    double diff = 0.0;
+    double energy = 0.0;
+    for (int i = 0; i + spectrumFrames <= ref.frames; i += spectrumFrames / 2) {
+      std::vector<double> ma = magnitudes(a + i);
+      std::vector<double> mb = magnitudes(b + i);
+      for (size_t k = 0; k < ma.size(); k++) {
+        diff += (mb[k] - ma[k]) * (mb[k] - ma[k]);
+        energy += ma[k] * ma[k];
+      }
+    }
+    if (diff > 0.0) {
+      // A silent reference is compared in absolute terms.
+      worst = std::max(worst, 10.0 * std::log10(diff / std::max(energy, 1.0)));
+    }
+    else if (!(diff == 0.0)) {
+      return INFINITY;
+    }
+  }
+  return worst;
+}
+
+/** Largest difference of any sample, NaN if the render has one. */
+static double maxError(const Reference& ref, const Reference& out) {
+  double err = 0.0;
+  for (size_t i = 0; i < ref.samples.size(); i++) {
+    double d = std::fabs((double) out.samples[i] - ref.samples[i]);
+    if (!(d <= err)) {
+      err = d;
+    }
+  }
+  return err;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 3 || (std::string(argv[1]) != "record" && std::string(argv[1]) != "check")) {
+    std::fprintf(stderr, "usage: %s record|check dir [maxAbs] [spectralDb] [filter]\n", argv[0]);
+    return 2;
+  }
+  bool record = std::string(argv[1]) == "record";
+  std::string dir = argv[2];
+  double maxAbs = (argc > 3) ? std::atof(argv[3]) : 1e-4;
+  double maxSpectralDb = (argc > 4) ? std::atof(argv[4]) : -80.0;
+  std::string filter = (argc > 5) ? argv[5] : "";
+
+  Window window;
+  Engine engine;
+  App app{&window, &engine};
+  appInstance = &app;
+  Module::ProcessArgs args{engine.sampleRate, 1.f / engine.sampleRate};
+
+  int failed = 0;
+  std::vector<Case> cases = allCases(filter);
+  for (const Case& c : cases) {
+    std::string path = dir + "/" + slug(c) + ".f32";
+    Reference out = reduce(render(c, args));
+    if (record) {
+      if (!save(path, out)) {
+        std::fprintf(stderr, "cannot write %s\n", path.c_str());
+        return 2;
+      }
+      std::printf("recorded  %s, %s\n", c.module.c_str(), c.name.c_str());
+      continue;
+    }
+
+    Reference ref;
+    if (!load(path, ref)) {
+      std::printf("MISSING   %s, %s\n", c.module.c_str(), c.name.c_str());
+      failed++;
+      continue;
+    }
+    if (ref.channels != out.channels) {
+      std::printf("FAIL      %s, %s: %d channels, reference has %d\n", c.module.c_str(), c.name.c_str(), out.channels, ref.channels);
+      failed++;
+      continue;
+    }
+    double err = maxError(ref, out);
+    double db = spectralError(ref, out);
+    bool ok = err <= maxAbs && db <= maxSpectralDb;
+    std::printf("%s %s, %s: max abs %.3g, spectral %.1f dB\n", ok ? "ok       " : "FAIL     ", c.module.c_str(), c.name.c_str(), err, db);
+    if (!ok) {
+      failed++;
+    }
+  }
+  if (!record) {
+    std::printf("%d of %d cases failed\n", failed, (int) cases.size());
+  }
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,603 @@
+#pragma once
+/* Minimal stand-in for the Rack v1 SDK headers, just enough to compile the
+   module sources and run process() headless, see bench/bench.cpp.
+   Numerics follow Rack where the output depends on them, the widget and
+   NanoVG parts only compile.
+*/
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <pmmintrin.h>
+
+#define ENUMS(name, count) name, name ## _LAST = name + (count) - 1
+
+namespace rack {
+
+namespace math {
+inline float clamp(float x, float a, float b) { return std::fmax(std::fmin(x, b), a); }
+inline int clamp(int x, int a, int b) { return std::max(std::min(x, b), a); }
+inline float rescale(float x, float xMin, float xMax, float yMin, float yMax) { return yMin + (x - xMin) / (xMax - xMin) * (yMax - yMin); }
+inline float crossfade(float a, float b, float p) { return a + (b - a) * p; }
+inline float sgn(float x) { return x > 0.f ? 1.f : (x < 0.f ? -1.f : 0.f); }
+inline int eucMod(int a, int b) { int m = a % b; if (m < 0) m += b; return m; }
+inline float eucMod(float a, float b) { float m = std::fmod(a, b); if (m < 0.f) m += b; return m; }
+inline bool isNear(float a, float b, float epsilon = 1e-6f) { return std::fabs(a - b) <= epsilon; }
+inline bool isPow2(int n) { return n > 0 && (n & (n - 1)) == 0; }
+struct Vec {
+	float x = 0.f, y = 0.f;
+	Vec() {}
+	Vec(float x, float y) : x(x), y(y) {}
+	float& operator[](int i) { return (i == 0) ? x : y; }
+	Vec neg() const { return Vec(-x, -y); }
+	Vec plus(Vec b) const { return Vec(x + b.x, y + b.y); }
+	Vec minus(Vec b) const { return Vec(x - b.x, y - b.y); }
+	Vec mult(float s) const { return Vec(x * s, y * s); }
+	Vec mult(Vec b) const { return Vec(x * b.x, y * b.y); }
+	Vec div(float s) const { return Vec(x / s, y / s); }
+	Vec div(Vec b) const { return Vec(x / b.x, y / b.y); }
+	float dot(Vec b) const { return x * b.x + y * b.y; }
+	float norm() const { return std::hypot(x, y); }
+	float square() const { return x * x + y * y; }
+	Vec normalize() const { return div(norm()); }
+	Vec min(Vec b) const { return Vec(std::fmin(x, b.x), std::fmin(y, b.y)); }
+	Vec max(Vec b) const { return Vec(std::fmax(x, b.x), std::fmax(y, b.y)); }
+	bool isEqual(Vec b) const { return x == b.x && y == b.y; }
+};
+struct Rect {
+	Vec pos, size;
+	Rect() {}
+	Rect(Vec pos, Vec size) : pos(pos), size(size) {}
+	Rect(float x, float y, float w, float h) : pos(x, y), size(w, h) {}
+	Vec getCenter() const { return pos.plus(size.mult(0.5f)); }
+};
+} // namespace math
+using namespace math;
+
+namespace simd {
+template <typename T, int N> struct Vector;
+template <>
+struct Vector<float, 4> {
+	union { __m128 v; float s[4]; };
+	Vector() = default;
+	Vector(__m128 v) : v(v) {}
+	Vector(float x) { v = _mm_set1_ps(x); }
+	Vector(float x1, float x2, float x3, float x4) { v = _mm_setr_ps(x1, x2, x3, x4); }
+	static Vector zero() { return Vector(_mm_setzero_ps()); }
+	static Vector mask() { return Vector(_mm_castsi128_ps(_mm_set1_epi32(-1))); }
+	static Vector load(const float* x) { return Vector(_mm_loadu_ps(x)); }
+	void store(float* x) { _mm_storeu_ps(x, v); }
+	float& operator[](int i) { return s[i]; }
+	const float& operator[](int i) const { return s[i]; }
+};
+typedef Vector<float, 4> float_4;
+
+#define STUB_OP(op, fn) \
+	inline float_4 operator op(const float_4& a, const float_4& b) { return float_4(fn(a.v, b.v)); } \
+	inline float_4 operator op(const float_4& a, float b) { return float_4(fn(a.v, _mm_set1_ps(b))); } \
+	inline float_4 operator op(float a, const float_4& b) { return float_4(fn(_mm_set1_ps(a), b.v)); }
+STUB_OP(+, _mm_add_ps)
+STUB_OP(-, _mm_sub_ps)
+STUB_OP(*, _mm_mul_ps)
+STUB_OP(/, _mm_div_ps)
+STUB_OP(==, _mm_cmpeq_ps)
+STUB_OP(!=, _mm_cmpneq_ps)
+STUB_OP(<, _mm_cmplt_ps)
+STUB_OP(<=, _mm_cmple_ps)
+STUB_OP(>, _mm_cmpgt_ps)
+STUB_OP(>=, _mm_cmpge_ps)
+STUB_OP(&, _mm_and_ps)
+STUB_OP(|, _mm_or_ps)
+STUB_OP(^, _mm_xor_ps)
+#undef STUB_OP
+inline float_4& operator+=(float_4& a, const float_4& b) { return a = a + b; }
+inline float_4& operator-=(float_4& a, const float_4& b) { return a = a - b; }
+inline float_4& operator*=(float_4& a, const float_4& b) { return a = a * b; }
+inline float_4& operator/=(float_4& a, const float_4& b) { return a = a / b; }
+inline float_4& operator&=(float_4& a, const float_4& b) { return a = a & b; }
+inline float_4& operator|=(float_4& a, const float_4& b) { return a = a | b; }
+inline float_4 operator-(const float_4& a) { return 0.f - a; }
+inline float_4 operator~(const float_4& a) { return a ^ float_4::mask(); }
+
+inline float_4 ifelse(float_4 mask, float_4 a, float_4 b) { return (mask & a) | float_4(_mm_andnot_ps(mask.v, b.v)); }
+inline float ifelse(bool cond, float a, float b) { return cond ? a : b; }
+inline int movemask(float_4 a) { return _mm_movemask_ps(a.v); }
+
+#define STUB_F1(name, fn) \
+	inline float_4 name(float_4 a) { return float_4(fn(a.s[0]), fn(a.s[1]), fn(a.s[2]), fn(a.s[3])); } \
+	inline float name(float a) { return fn(a); }
+STUB_F1(floor, std::floor)
+STUB_F1(ceil, std::ceil)
+STUB_F1(round, std::round)
+STUB_F1(trunc, std::trunc)
+STUB_F1(sqrt, std::sqrt)
+STUB_F1(abs, std::fabs)
+STUB_F1(exp, std::exp)
+STUB_F1(log, std::log)
+STUB_F1(log2, std::log2)
+STUB_F1(exp2, std::exp2)
+STUB_F1(sin, std::sin)
+STUB_F1(cos, std::cos)
+STUB_F1(tan, std::tan)
+STUB_F1(atan, std::atan)
+#undef STUB_F1
+inline float_4 rsqrt(float_4 a) { return float_4(_mm_rsqrt_ps(a.v)); }
+inline float_4 rcp(float_4 a) { return float_4(_mm_rcp_ps(a.v)); }
+inline float_4 fmin(float_4 a, float_4 b) { return float_4(_mm_min_ps(a.v, b.v)); }
+inline float_4 fmax(float_4 a, float_4 b) { return float_4(_mm_max_ps(a.v, b.v)); }
+inline float fmin(float a, float b) { return std::fmin(a, b); }
+inline float fmax(float a, float b) { return std::fmax(a, b); }
+inline float_4 pow(float_4 a, float_4 b) { return float_4(std::pow(a.s[0], b.s[0]), std::pow(a.s[1], b.s[1]), std::pow(a.s[2], b.s[2]), std::pow(a.s[3], b.s[3])); }
+inline float_4 pow(float a, float_4 b) { return pow(float_4(a), b); }
+inline float pow(float a, float b) { return std::pow(a, b); }
+inline float_4 atan2(float_4 a, float_4 b) { return float_4(std::atan2(a.s[0], b.s[0]), std::atan2(a.s[1], b.s[1]), std::atan2(a.s[2], b.s[2]), std::atan2(a.s[3], b.s[3])); }
+inline float atan2(float a, float b) { return std::atan2(a, b); }
+inline float_4 fmod(float_4 a, float_4 b) { return a - trunc(a / b) * b; }
+inline float_4 clamp(float_4 x, float_4 a, float_4 b) { return fmin(fmax(x, a), b); }
+inline float clamp(float x, float a, float b) { return math::clamp(x, a, b); }
+inline float_4 rescale(float_4 x, float_4 xMin, float_4 xMax, float_4 yMin, float_4 yMax) { return yMin + (x - xMin) / (xMax - xMin) * (yMax - yMin); }
+inline float rescale(float x, float a, float b, float c, float d) { return math::rescale(x, a, b, c, d); }
+inline float_4 crossfade(float_4 a, float_4 b, float_4 p) { return a + (b - a) * p; }
+inline float_4 sgn(float_4 x) { return ifelse(x > 0.f, 1.f, ifelse(x < 0.f, -1.f, 0.f)); }
+} // namespace simd
+
+namespace dsp {
+static const float FREQ_C4 = 261.6256f;
+template <typename T = float>
+struct TSchmittTrigger {
+	T state;
+	TSchmittTrigger() { reset(); }
+	void reset() { state = T::mask(); }
+	T process(T in) {
+		T on = (in >= 1.f);
+		T off = (in <= 0.f);
+		T triggered = ~state & on;
+		state = on | (state & ~off);
+		return triggered;
+	}
+	T isHigh() { return state; }
+};
+template <>
+struct TSchmittTrigger<float> {
+	bool state = true;
+	void reset() { state = true; }
+	bool process(float in) {
+		if (state) { if (in <= 0.f) state = false; }
+		else if (in >= 1.f) { state = true; return true; }
+		return false;
+	}
+	bool isHigh() { return state; }
+};
+typedef TSchmittTrigger<> SchmittTrigger;
+struct PulseGenerator {
+	float remaining = 0.f;
+	void reset() { remaining = 0.f; }
+	bool process(float deltaTime) {
+		if (remaining > 0.f) { remaining -= deltaTime; return true; }
+		return false;
+	}
+	void trigger(float duration = 1e-3f) { if (duration > remaining) remaining = duration; }
+};
+struct ClockDivider {
+	uint32_t clock = 0;
+	uint32_t division = 1;
+	void reset() { clock = 0; }
+	void setDivision(uint32_t division) { this->division = division; }
+	uint32_t getDivision() { return division; }
+	uint32_t getClock() { return clock; }
+	bool process() { clock++; if (clock >= division) { clock = 0; return true; } return false; }
+};
+template <typename T, size_t S>
+struct RingBuffer {
+	std::atomic<size_t> start{0};
+	std::atomic<size_t> end{0};
+	T data[S];
+	size_t mask(size_t i) const { return i & (S - 1); }
+	void push(T t) { size_t i = mask(end); data[i] = t; end++; }
+	T shift() { size_t i = mask(start); T t = data[i]; start++; return t; }
+	void clear() { start = end.load(); }
+	bool empty() const { return start == end; }
+	bool full() const { return end - start == S; }
+	size_t size() const { return end - start; }
+	size_t capacity() const { return S - size(); }
+};
+struct RealFFT {
+	size_t length;
+	RealFFT(size_t length) : length(length) {}
+	// Naive DFT producing pffft's ordered layout (DC, Nyquist, re1, im1, ...).
+	void rfft(const float* input, float* output) {
+		size_t n = length;
+		output[0] = 0.f; output[1] = 0.f;
+		for (size_t i = 0; i < n; i++) { output[0] += input[i]; output[1] += (i & 1) ? -input[i] : input[i]; }
+		for (size_t k = 1; k < n / 2; k++) {
+			double re = 0.0, im = 0.0;
+			for (size_t i = 0; i < n; i++) {
+				double a = -2.0 * M_PI * (double) k * (double) i / (double) n;
+				re += input[i] * std::cos(a);
+				im += input[i] * std::sin(a);
+			}
+			output[2 * k] = re; output[2 * k + 1] = im;
+		}
+	}
+	void irfft(const float* input, float* output) {
+		size_t n = length;
+		for (size_t i = 0; i < n; i++) {
+			double v = input[0] + ((i & 1) ? -input[1] : input[1]);
+			for (size_t k = 1; k < n / 2; k++) {
+				double a = 2.0 * M_PI * (double) k * (double) i / (double) n;
+				v += 2.0 * (input[2 * k] * std::cos(a) - input[2 * k + 1] * std::sin(a));
+			}
+			output[i] = v;
+		}
+	}
+	void scale(float* x) { for (size_t i = 0; i < length; i++) x[i] /= length; }
+};
+} // namespace dsp
+
+namespace random {
+inline uint32_t u32() { return (uint32_t) std::rand(); }
+inline uint64_t u64() { return ((uint64_t) u32() << 32) | u32(); }
+inline float uniform() { return (float) std::rand() / ((float) RAND_MAX + 1.f); }
+inline float normal() { return 0.f; }
+} // namespace random
+
+} // namespace rack
+
+// Minimal jansson stand-in.
+typedef long long json_int_t;
+struct json_t {
+	enum Type { OBJECT, ARRAY, INTEGER, REAL, TRUE_, FALSE_, STRING } type;
+	long long i = 0;
+	double r = 0.0;
+	std::string s;
+	std::map<std::string, json_t*> obj;
+	std::vector<json_t*> arr;
+};
+inline void json_decref(json_t* j) { if (!j) return; for (auto& kv : j->obj) json_decref(kv.second); for (json_t* e : j->arr) json_decref(e); delete j; }
+inline json_t* json_object() { json_t* j = new json_t; j->type = json_t::OBJECT; return j; }
+inline json_t* json_array() { json_t* j = new json_t; j->type = json_t::ARRAY; return j; }
+inline int json_array_append_new(json_t* a, json_t* v) { a->arr.push_back(v); return 0; }
+inline json_t* json_array_get(const json_t* a, size_t i) { return a && a->type == json_t::ARRAY && i < a->arr.size() ? a->arr[i] : NULL; }
+inline size_t json_array_size(const json_t* a) { return a && a->type == json_t::ARRAY ? a->arr.size() : 0; }
+inline json_t* json_integer(long long v) { json_t* j = new json_t; j->type = json_t::INTEGER; j->i = v; return j; }
+inline json_t* json_real(double v) { json_t* j = new json_t; j->type = json_t::REAL; j->r = v; return j; }
+inline json_t* json_boolean(bool v) { json_t* j = new json_t; j->type = v ? json_t::TRUE_ : json_t::FALSE_; return j; }
+inline json_t* json_true() { return json_boolean(true); }
+inline json_t* json_false() { return json_boolean(false); }
+inline json_t* json_string(const char* v) { json_t* j = new json_t; j->type = json_t::STRING; j->s = v; return j; }
+inline int json_object_set_new(json_t* o, const char* k, json_t* v) { auto it = o->obj.find(k); if (it != o->obj.end()) json_decref(it->second); o->obj[k] = v; return 0; }
+inline json_t* json_object_get(const json_t* o, const char* k) { auto it = o->obj.find(k); return it == o->obj.end() ? NULL : it->second; }
+inline long long json_integer_value(const json_t* j) { return j && j->type == json_t::INTEGER ? j->i : 0; }
+inline double json_real_value(const json_t* j) { return j && j->type == json_t::REAL ? j->r : 0.0; }
+inline double json_number_value(const json_t* j) { return !j ? 0.0 : j->type == json_t::INTEGER ? (double) j->i : j->type == json_t::REAL ? j->r : 0.0; }
+inline bool json_is_true(const json_t* j) { return j && j->type == json_t::TRUE_; }
+inline bool json_boolean_value(const json_t* j) { return json_is_true(j); }
+inline const char* json_string_value(const json_t* j) { return j && j->type == json_t::STRING ? j->s.c_str() : NULL; }
+
+// Minimal NanoVG stand-in.
+struct NVGcontext;
+struct NVGcolor { float r, g, b, a; };
+inline NVGcolor nvgRGB(unsigned char r, unsigned char g, unsigned char b) { return NVGcolor{r / 255.f, g / 255.f, b / 255.f, 1.f}; }
+inline NVGcolor nvgRGBA(unsigned char r, unsigned char g, unsigned char b, unsigned char a) { return NVGcolor{r / 255.f, g / 255.f, b / 255.f, a / 255.f}; }
+inline NVGcolor nvgRGBf(float r, float g, float b) { return NVGcolor{r, g, b, 1.f}; }
+inline void nvgBeginPath(NVGcontext*) {}
+inline void nvgClosePath(NVGcontext*) {}
+inline void nvgMoveTo(NVGcontext*, float, float) {}
+inline void nvgLineTo(NVGcontext*, float, float) {}
+inline void nvgBezierTo(NVGcontext*, float, float, float, float, float, float) {}
+inline void nvgCircle(NVGcontext*, float, float, float) {}
+inline void nvgRect(NVGcontext*, float, float, float, float) {}
+inline void nvgRoundedRect(NVGcontext*, float, float, float, float, float) {}
+inline void nvgStrokeColor(NVGcontext*, NVGcolor) {}
+inline void nvgFillColor(NVGcontext*, NVGcolor) {}
+inline void nvgStrokeWidth(NVGcontext*, float) {}
+inline void nvgStroke(NVGcontext*) {}
+inline void nvgFill(NVGcontext*) {}
+inline void nvgSave(NVGcontext*) {}
+inline void nvgRestore(NVGcontext*) {}
+inline void nvgScissor(NVGcontext*, float, float, float, float) {}
+inline void nvgResetScissor(NVGcontext*) {}
+
+namespace rack {
+
+namespace event {
+struct Action {};
+struct Change {};
+struct ExpanderChange {};
+} // namespace event
+
+namespace engine {
+static const int PORT_MAX_CHANNELS = 16;
+struct Param {
+	float value = 0.f;
+	float getValue() { return value; }
+	void setValue(float value) { this->value = value; }
+};
+struct ParamQuantity {
+	std::string label, unit;
+	float minValue = 0.f, maxValue = 1.f, defaultValue = 0.f;
+	Param* param = NULL;
+	virtual ~ParamQuantity() {}
+	virtual void setValue(float value) { if (param) param->setValue(math::clamp(value, minValue, maxValue)); }
+	virtual float getValue() { return param ? param->getValue() : 0.f; }
+	virtual std::string getLabel() { return label; }
+	float getMinValue() { return minValue; }
+	float getMaxValue() { return maxValue; }
+	float getDefaultValue() { return defaultValue; }
+};
+struct Port {
+	union { float voltages[PORT_MAX_CHANNELS] = {}; float value; };
+	uint8_t channels = 0;
+	void setVoltage(float voltage, int channel = 0) { voltages[channel] = voltage; }
+	float getVoltage(int channel = 0) { return voltages[channel]; }
+	float getPolyVoltage(int channel) { return isMonophonic() ? getVoltage(0) : getVoltage(channel); }
+	float getNormalVoltage(float normalVoltage, int channel = 0) { return isConnected() ? getVoltage(channel) : normalVoltage; }
+	float getNormalPolyVoltage(float normalVoltage, int channel) { return isConnected() ? getPolyVoltage(channel) : normalVoltage; }
+	float getVoltageSum() { float s = 0.f; for (int c = 0; c < channels; c++) s += voltages[c]; return s; }
+	template <typename T> T getVoltageSimd(int firstChannel) { return T::load(&voltages[firstChannel]); }
+	template <typename T> T getPolyVoltageSimd(int firstChannel) { return isMonophonic() ? T(getVoltage(0)) : getVoltageSimd<T>(firstChannel); }
+	template <typename T> void setVoltageSimd(T voltage, int firstChannel) { voltage.store(&voltages[firstChannel]); }
+	void setChannels(int channels) {
+		if (this->channels == 0) return;
+		for (int c = channels; c < this->channels; c++) voltages[c] = 0.f;
+		if (channels == 0) channels = 1;
+		this->channels = channels;
+	}
+	int getChannels() { return channels; }
+	bool isConnected() { return channels > 0; }
+	bool isMonophonic() { return channels == 1; }
+	bool isPolyphonic() { return channels > 1; }
+};
+struct Output : Port {};
+struct Input : Port {};
+struct Light {
+	float value = 0.f;
+	void setBrightness(float brightness) { value = brightness; }
+	float getBrightness() { return value; }
+	void setBrightnessSmooth(float brightness, float deltaTime, float lambda = 30.f) { value += (brightness - value) * lambda * deltaTime; }
+};
+struct Module {
+	struct ProcessArgs { float sampleRate; float sampleTime; };
+	struct Expander {
+		int moduleId = -1;
+		Module* module = NULL;
+		void* producerMessage = NULL;
+		void* consumerMessage = NULL;
+		bool messageFlipRequested = false;
+	};
+	int id = -1;
+	void* model = NULL;
+	std::vector<Param> params;
+	std::vector<Input> inputs;
+	std::vector<Output> outputs;
+	std::vector<Light> lights;
+	std::vector<ParamQuantity*> paramQuantities;
+	Expander leftExpander, rightExpander;
+	virtual ~Module() { for (ParamQuantity* pq : paramQuantities) delete pq; }
+	void config(int numParams, int numInputs, int numOutputs, int numLights = 0) {
+		params.resize(numParams); inputs.resize(numInputs); outputs.resize(numOutputs); lights.resize(numLights);
+		paramQuantities.resize(numParams, NULL);
+	}
+	template <class TParamQuantity = ParamQuantity>
+	void configParam(int paramId, float minValue, float maxValue, float defaultValue, std::string label = "", std::string unit = "", float displayBase = 0.f, float displayMultiplier = 1.f, float displayOffset = 0.f) {
+		delete paramQuantities[paramId];
+		TParamQuantity* q = new TParamQuantity;
+		q->param = &params[paramId];
+		q->minValue = minValue; q->maxValue = maxValue; q->defaultValue = defaultValue;
+		q->label = label; q->unit = unit;
+		paramQuantities[paramId] = q;
+		params[paramId].value = defaultValue;
+	}
+	virtual void process(const ProcessArgs& args) {}
+	virtual void onAdd() {}
+	virtual void onRemove() {}
+	virtual void onReset() {}
+	virtual void onRandomize() {}
+	virtual void onSampleRateChange() {}
+	virtual void onExpanderChange(const event::ExpanderChange& e) {}
+	virtual json_t* dataToJson() { return NULL; }
+	virtual void dataFromJson(json_t* rootJ) {}
+	// Params, then data, as in Rack.
+	virtual void fromJson(json_t* rootJ) {
+		json_t* paramsJ = rootJ ? json_object_get(rootJ, "params") : NULL;
+		for (size_t i = 0; i < json_array_size(paramsJ); i++) {
+			json_t* paramJ = json_array_get(paramsJ, i);
+			json_t* idJ = json_object_get(paramJ, "id");
+			int paramId = json_integer_value(idJ);
+			if (idJ && paramId >= 0 && paramId < (int) params.size())
+				params[paramId].value = json_number_value(json_object_get(paramJ, "value"));
+		}
+		json_t* dataJ = rootJ ? json_object_get(rootJ, "data") : NULL;
+		if (dataJ) dataFromJson(dataJ);
+	}
+};
+} // namespace engine
+using namespace engine;
+
+struct Svg {};
+namespace asset { inline std::string plugin(void*, std::string path) { return path; } }
+
+namespace widget {
+struct Widget {
+	struct DrawArgs { NVGcontext* vg = NULL; Rect clipBox; };
+	Rect box;
+	Widget* parent = NULL;
+	std::vector<Widget*> children;
+	bool visible = true;
+	virtual ~Widget() { for (Widget* w : children) delete w; }
+	void addChild(Widget* w) { if (w) { w->parent = this; children.push_back(w); } }
+	virtual void step() { for (Widget* w : children) w->step(); }
+	virtual void draw(const DrawArgs& args) { for (Widget* w : children) w->draw(args); }
+	void show() { visible = true; }
+	void hide() { visible = false; }
+};
+struct TransparentWidget : Widget {};
+struct OpaqueWidget : Widget {};
+struct FramebufferWidget : Widget { bool dirty = true; };
+struct TransformWidget : Widget {
+	float transform[6] = {1, 0, 0, 1, 0, 0};
+	void identity() { float t[6] = {1, 0, 0, 1, 0, 0}; std::copy(t, t + 6, transform); }
+	void translate(Vec d) { transform[4] += transform[0] * d.x + transform[2] * d.y; transform[5] += transform[1] * d.x + transform[3] * d.y; }
+	void rotate(float angle) {
+		float c = std::cos(angle), s = std::sin(angle);
+		float a = transform[0], b = transform[1], cc = transform[2], d = transform[3];
+		transform[0] = a * c + cc * s; transform[1] = b * c + d * s;
+		transform[2] = cc * c - a * s; transform[3] = d * c - b * s;
+	}
+};
+struct SvgWidget : Widget { void setSvg(std::shared_ptr<Svg>) {} };
+} // namespace widget
+using namespace widget;
+
+struct Window { std::shared_ptr<Svg> loadSvg(std::string) { return std::make_shared<Svg>(); } };
+struct Engine {
+	float sampleRate = 44100.f;
+	float getSampleRate() { return sampleRate; }
+	float getSampleTime() { return 1.f / sampleRate; }
+};
+struct App { Window* window; Engine* engine; };
+extern App* appInstance;
+#define APP rack::appInstance
+
+namespace ui {
+struct Quantity {
+	virtual ~Quantity() {}
+	virtual void setValue(float) {}
+	virtual float getValue() { return 0.f; }
+	virtual float getMinValue() { return 0.f; }
+	virtual float getMaxValue() { return 1.f; }
+	virtual float getDefaultValue() { return 0.f; }
+	virtual std::string getLabel() { return ""; }
+	virtual std::string getUnit() { return ""; }
+	virtual int getDisplayPrecision() { return 5; }
+	virtual std::string getDisplayValueString() { return ""; }
+};
+struct Menu : Widget {};
+struct MenuEntry : OpaqueWidget {};
+struct MenuLabel : MenuEntry { std::string text; };
+struct MenuSeparator : MenuEntry {};
+struct MenuItem : MenuEntry {
+	std::string text, rightText;
+	bool disabled = false;
+	virtual Menu* createChildMenu() { return NULL; }
+	virtual void onAction(const event::Action& e) {}
+};
+struct Slider : OpaqueWidget { Quantity* quantity = NULL; };
+} // namespace ui
+using namespace ui;
+inline MenuLabel* createMenuLabel(std::string text) { MenuLabel* l = new MenuLabel; l->text = text; return l; }
+template <class TMenuItem = MenuItem>
+TMenuItem* createMenuItem(std::string text, std::string rightText = "") { TMenuItem* i = new TMenuItem; i->text = text; i->rightText = rightText; return i; }
+#define CHECKMARK_STRING "✔"
+#define CHECKMARK(_cond) ((_cond) ? CHECKMARK_STRING : "")
+#define RIGHT_ARROW "▸"
+
+namespace app {
+static const float RACK_GRID_WIDTH = 15;
+static const float RACK_GRID_HEIGHT = 380;
+struct ParamWidget : OpaqueWidget {
+	ParamQuantity* paramQuantity = NULL;
+	float dirtyValue = NAN;
+	virtual void onChange(const event::Change& e) {}
+	void step() override {
+		if (paramQuantity && paramQuantity->getValue() != dirtyValue) {
+			dirtyValue = paramQuantity->getValue();
+			event::Change eChange;
+			onChange(eChange);
+		}
+		OpaqueWidget::step();
+	}
+};
+struct CircularShadow : TransparentWidget { float blurRadius = 0.f; float opacity = 0.15f; };
+struct Knob : ParamWidget { bool snap = false; bool smooth = true; };
+struct SvgKnob : Knob {
+	FramebufferWidget* fb = new FramebufferWidget;
+	TransformWidget* tw = new TransformWidget;
+	SvgWidget* sw = new SvgWidget;
+	CircularShadow* shadow = new CircularShadow;
+	float minAngle = -M_PI;
+	float maxAngle = M_PI;
+	SvgKnob() { addChild(fb); fb->addChild(tw); tw->addChild(sw); }
+	~SvgKnob() { delete shadow; }
+	void setSvg(std::shared_ptr<Svg>) {}
+	void onChange(const event::Change& e) override {
+		if (!paramQuantity) return;
+		float angle = math::rescale(paramQuantity->getValue(), paramQuantity->getMinValue(), paramQuantity->getMaxValue(), minAngle, maxAngle);
+		tw->identity();
+		Vec center = sw->box.getCenter();
+		tw->translate(center);
+		tw->rotate(angle);
+		tw->translate(center.neg());
+		fb->dirty = true;
+	}
+};
+struct RoundKnob : SvgKnob { RoundKnob() { minAngle = -0.83f * M_PI; maxAngle = 0.83f * M_PI; } };
+struct SvgSwitch : ParamWidget { CircularShadow* shadow = new CircularShadow; void addFrame(std::shared_ptr<Svg>) {} ~SvgSwitch() { delete shadow; } };
+struct PortWidget : OpaqueWidget {};
+struct SvgPort : PortWidget { CircularShadow* shadow = new CircularShadow; void setSvg(std::shared_ptr<Svg>) {} ~SvgPort() { delete shadow; } };
+struct PJ301MPort : SvgPort {};
+struct ModuleLightWidget : Widget {};
+struct GrayModuleLightWidget : ModuleLightWidget {};
+struct GreenLight : GrayModuleLightWidget {};
+struct RedLight : GrayModuleLightWidget {};
+struct BlueLight : GrayModuleLightWidget {};
+struct YellowLight : GrayModuleLightWidget {};
+template <typename T> struct TinyLight : T {};
+template <typename T> struct SmallLight : T {};
+template <typename T> struct MediumLight : T {};
+struct ScrewSilver : SvgWidget {};
+struct ModuleWidget : OpaqueWidget {
+	Module* module = NULL;
+	void setModule(Module* m) { module = m; }
+	void setPanel(std::shared_ptr<Svg>) { box.size = Vec(RACK_GRID_WIDTH * 10, RACK_GRID_HEIGHT); }
+	void addParam(ParamWidget* w) { addChild(w); }
+	void addInput(PortWidget* w) { addChild(w); }
+	void addOutput(PortWidget* w) { addChild(w); }
+	virtual void appendContextMenu(Menu* menu) {}
+};
+} // namespace app
+using namespace app;
+
+inline Vec mm2px(Vec mm) { return mm.mult(75.f / 25.4f); }
+template <class TWidget> TWidget* createWidget(Vec pos) { TWidget* w = new TWidget; w->box.pos = pos; return w; }
+template <class TWidget> TWidget* createWidgetCentered(Vec pos) { TWidget* w = createWidget<TWidget>(pos); w->box.pos = w->box.pos.minus(w->box.size.div(2)); return w; }
+template <class TParamWidget> TParamWidget* createParam(Vec pos, Module* module, int paramId) { TParamWidget* o = createWidget<TParamWidget>(pos); if (module) o->paramQuantity = module->paramQuantities[paramId]; return o; }
+template <class TParamWidget> TParamWidget* createParamCentered(Vec pos, Module* module, int paramId) { return createParam<TParamWidget>(pos, module, paramId); }
+template <class TPortWidget> TPortWidget* createInputCentered(Vec pos, Module* module, int inputId) { return createWidget<TPortWidget>(pos); }
+template <class TPortWidget> TPortWidget* createOutputCentered(Vec pos, Module* module, int outputId) { return createWidget<TPortWidget>(pos); }
+template <class TPortWidget> TPortWidget* createInput(Vec pos, Module* module, int inputId) { return createWidget<TPortWidget>(pos); }
+template <class TPortWidget> TPortWidget* createOutput(Vec pos, Module* module, int outputId) { return createWidget<TPortWidget>(pos); }
+template <class TLightWidget> TLightWidget* createLightCentered(Vec pos, Module* module, int lightId) { return createWidget<TLightWidget>(pos); }
+
+namespace plugin {
+struct Model {
+	std::string slug;
+	virtual ~Model() {}
+	virtual Module* createModule() = 0;
+	virtual ModuleWidget* createModuleWidget() = 0;
+};
+struct Plugin { std::vector<Model*> models; void addModel(Model* m) { models.push_back(m); } };
+std::vector<Model*>& registry();
+} // namespace plugin
+using namespace plugin;
+
+template <class TModule, class TModuleWidget>
+Model* createModel(std::string slug) {
+	struct TModel : Model {
+		Module* createModule() override { return new TModule; }
+		ModuleWidget* createModuleWidget() override { TModule* m = new TModule; TModuleWidget* w = new TModuleWidget(m); return w; }
+	};
+	TModel* o = new TModel;
+	o->slug = slug;
+	registry().push_back(o);
+	return o;
+}
+
+} // namespace rack
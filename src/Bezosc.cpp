@@ -1,7 +1,152 @@
 #include "plugin.hpp"
 #include "bezosccomponent.hpp"
+#include "halfband.hpp"
+#include "wavetable.hpp"
+#include "fastmath.hpp"
+#include "bezier.hpp"
+#include "splineshare.hpp"
+#include "uisync.hpp"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
 using simd::float_4;
 
+/** Two dimensional vector of four voices, the float_4 counterpart of the 
+    few Vec operations the spline needs. The operators let the kernels in 
+    bezier.hpp take it as a point type.
+*/
+struct Vec_4 {
+  float_4 x = 0.f;
+  float_4 y = 0.f;
+
+  Vec_4() {}
+  Vec_4(float_4 x, float_4 y) : x(x), y(y) {}
+
+  Vec_4 plus(Vec_4 b) const {return Vec_4(x + b.x, y + b.y);}
+  Vec_4 minus(Vec_4 b) const {return Vec_4(x - b.x, y - b.y);}
+  Vec_4 mult(float_4 s) const {return Vec_4(x * s, y * s);}
+  Vec_4 normalize() const {
+    float_4 n = simd::sqrt(x * x + y * y);
+    return Vec_4(x / n, y / n);
+  }
+  static Vec_4 ifelse(float_4 mask, Vec_4 a, Vec_4 b){
+    return Vec_4(simd::ifelse(mask, a.x, b.x), simd::ifelse(mask, a.y, b.y));
+  }
+
+  Vec_4 operator+(Vec_4 b) const {return plus(b);}
+  Vec_4 operator-(Vec_4 b) const {return minus(b);}
+  Vec_4 operator*(float_4 s) const {return mult(s);}
+};
+
+/** Reparameterization by arc length of a closed spline of S power basis 
+    segments, for four voices. Maps the phase to the spline parameter so 
+    that the position moves at constant speed.
+    Rebuilt incrementally, a few intervals per sample, while the previous 
+    table keeps playing.
+*/
+template <int S>
+struct ArcLengthTable {
+  static const int size = 256;
+  static const int intervals = 256;
+  static const int integrateChunk = 8;
+  static const int invertChunk = 32;
+
+  // Spline parameter in [0, S] at equidistant arc length, front and back.
+  float_4 tau[2][size + 1];
+  // Arc length at equidistant parameter, integrated by Simpson's rule.
+  float_4 cumulative[intervals + 1];
+  int front = 0;
+  // 0 idle, 1 integrating, 2 inverting.
+  int stage = 0;
+  int pos = 0;
+  int walk[4];
+  bool dirty = true;
+
+  ArcLengthTable() {
+    for (int j = 0; j <= size; j++){
+      tau[0][j] = tau[1][j] = (float) j * S / size;
+    }
+  }
+
+  static float_4 speed(const Vec_4* K, float_4 t){
+    Vec_4 d = bezierHornerTangent(K, t);
+    return simd::sqrt(d.x * d.x + d.y * d.y);
+  }
+
+  /** Advances the rebuild by one chunk. A change during a rebuild is picked
+      up by the next one, so a constantly moving shape still gets fresh tables.
+  */
+  void update(bool moved, const Vec_4 (*coefs)[4]){
+    dirty |= moved;
+    if (stage == 0){
+      if (!dirty){
+        return;
+      }
+      dirty = false;
+      stage = 1;
+      pos = 0;
+      cumulative[0] = 0.f;
+    }
+    const float h = (float) S / intervals;
+    if (stage == 1){
+      int end = std::min(pos + integrateChunk, intervals);
+      for (; pos < end; pos++){
+        int seg = pos * S / intervals;
+        float t0 = pos * h - seg;
+        const Vec_4* K = coefs[seg];
+        float_4 l = speed(K, t0) + 4.f * speed(K, t0 + 0.5f * h) + speed(K, t0 + h);
+        cumulative[pos + 1] = cumulative[pos] + l * (h / 6.f);
+      }
+      if (pos == intervals){
+        stage = 2;
+        pos = 0;
+        for (int l = 0; l < 4; l++){
+          walk[l] = 0;
+        }
+      }
+      return;
+    }
+    float_4* back = tau[1 - front];
+    float_4 total = cumulative[intervals];
+    int end = std::min(pos + invertChunk, size + 1);
+    for (; pos < end; pos++){
+      for (int l = 0; l < 4; l++){
+        if (!(total[l] > 0.f)){
+          back[pos][l] = (float) pos * S / size;
+          continue;
+        }
+        float target = total[l] * pos / size;
+        int& w = walk[l];
+        while (w < intervals - 1 && cumulative[w + 1][l] < target){
+          w++;
+        }
+        float a = cumulative[w][l];
+        float b = cumulative[w + 1][l];
+        float frac = (b > a) ? clamp((target - a) / (b - a), 0.f, 1.f) : 0.f;
+        back[pos][l] = (w + frac) * h;
+      }
+    }
+    if (pos == size + 1){
+      front = 1 - front;
+      stage = 0;
+    }
+  }
+
+  /** Spline parameter for phase in [0, 1), per lane interpolated. */
+  float_4 map(float_4 phase){
+    const float_4* T = tau[front];
+    float_4 out;
+    for (int l = 0; l < 4; l++){
+      float p = phase[l] * size;
+      int i = std::min((int) p, size - 1);
+      float frac = p - i;
+      out[l] = T[i][l] + (T[i + 1][l] - T[i][l]) * frac;
+    }
+    return out;
+  }
+};
+
 struct Bezosc : Module {
 	enum ParamIds {
 		ENUMS(PBEZ_PARAM, 24),
@@ -20,6 +165,8 @@ struct Bezosc : Module {
 	enum InputIds {
 		ENUMS(IBEZ_INPUT, 24),
 		IBEZFREQ_INPUT,
+		BUSA_INPUT,
+		BUSB_INPUT,
 		NUM_INPUTS
 	};
 	enum OutputIds {
@@ -43,6 +190,8 @@ struct Bezosc : Module {
   static const int numDims = 2;
   static const int doublePoints = 4;
   static const int numXY = (numSegments * pointsSegment * numDims) - (doublePoints * numDims);
+  // float_4 of the shape bus, 16 channels on bus A, 8 on bus B.
+  static const int numBus = numXY / 4;
 
   const float defaults[numXY] = { //approx. circle r=4
     -2.2092f, 4.f,     0.f, 4.f, 2.2092f, 4.f,
@@ -74,9 +223,111 @@ struct Bezosc : Module {
     }
   };
 
-  float steps = 0;
+  // Knobs that only show a handle derived from the other knob of the pair,
+  // per modus. buildSpline ignores their params, so they are skipped by the
+  // change detection, and the knobs draw shownHandles instead.
+  const bool derivedHandles[4][numXY] = {
+    {},
+    {},
+    {
+      0,1,0,0,0,0, 0,1,0,0,0,0,
+      0,1,0,0,0,0, 0,1,0,0,0,0
+    },{
+      1,1,0,0,0,0, 1,1,0,0,0,0,
+      1,1,0,0,0,0, 1,1,0,0,0,0
+    }
+  };
+
+  float_4 steps[4] = {};
   float oldModus = 0;
 
+  // Lights and derived handle knobs only change at the UI rate.
+  UiClock uiClock;
+  UiValues<NUM_LIGHTS> uiLights;
+  UiValues<numXY> uiHandles;
+  // Handle each knob shows instead of its param, NaN where it shows its
+  // param. Written on the UI clock, read by the knob widgets.
+  float shownHandles[numXY];
+
+  // Power basis coefficients {a, b, c, d} of every segment, per group of
+  // four voices. Only rebuilt when the xy values or the modus change.
+  Vec_4 coefs[4][numSegments][pointsSegment];
+  float_4 xyCache[4][numXY] = {};
+  int coefModus[4] = {};
+
+  // Oversampling factor 1, 2, 4 or 8, set from the context menu.
+  int oversample = 1;
+  int decimatorFactor = 1;
+  CascadeDecimator<float_4> decimators[4][NUM_OUTPUTS];
+
+  // Constant speed traversal, the phase is mapped through an arc length table.
+  bool arcLength = false;
+  ArcLengthTable<numSegments> arcTables[4];
+
+  // Polynomial approximations for the theta and length outputs, see fastmath.hpp.
+  bool fast = false;
+
+  // Baked mode, a worker thread renders the settled shape of voice 1 into
+  // band-limited wavetables and the audio thread only plays them back.
+  // The worker and the tables only exist once baked mode is switched on,
+  // the worker is joined again when it is switched off.
+  struct BakeRequest {
+    // Coefficients of voice 1, x and y.
+    float coefs[2][numSegments][pointsSegment];
+    bool active[NUM_OUTPUTS];
+    bool arcLength;
+    int serial;
+  };
+  struct BakedTable {
+    MipMapTable waves[NUM_OUTPUTS];
+    bool active[NUM_OUTPUTS] = {};
+    int serial = -1;
+  };
+  static constexpr float bakeSettleTime = 0.05f;
+  // The worker looks for a posted request this often, well within the
+  // settle time.
+  static const int bakePollMs = 10;
+  static const int bakedFresh = 4;
+
+  bool baked = false;
+  bool bakePending = true;
+  int bakeSettle = 0;
+  int bakeSerial = 0;
+  bool bakeActive[NUM_OUTPUTS] = {};
+  bool bakeArcLength = false;
+  BakeRequest bakeRequest;
+  // 0 free, 1 posted by the audio thread, 2 taken by the worker.
+  std::atomic<int> bakeRequestState {0};
+  // Triple buffer, front is played, back is rendered, middle is swapped
+  // atomically. Allocated with the first worker and kept.
+  std::unique_ptr<BakedTable[]> bakedTables;
+  int bakedFront = 0;
+  int bakedBack = 1;
+  std::atomic<int> bakedMiddle {2};
+  std::thread bakeThread;
+  std::mutex bakeMutex;
+  std::condition_variable bakeCv;
+  bool bakeStop = false;
+
+  // Shape display, the widget asks for one snapshot per frame and the audio
+  // thread answers through a lock-free single producer, single consumer buffer.
+  struct DisplaySnapshot {
+    Vec points[numSegments][pointsSegment];
+    float tau;
+  };
+  dsp::RingBuffer<DisplaySnapshot, 4> displayBuffer;
+  std::atomic<bool> displayRequest {false};
+
+  // Spline sharing with the neighbours, see splineshare.hpp. Both buffers
+  // of the left expander are ours. Following the left module, its spline
+  // replaces the knobs, inputs and modus for every voice.
+  SplineMessage splineMessages[2];
+  bool followLeft = false;
+  uint32_t followSerial[4] = {};
+  int followSource[4] = {-1, -1, -1, -1};
+  uint32_t publishSerial = 0;
+  int publishTarget = -1;
+
 	Bezosc() {
 		config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
     for (int i = 0; i < numXY; i++) {
@@ -92,179 +343,889 @@ struct Bezosc : Module {
 		configParam(PTANSCALEL_PARAM,  0.f, 2.f, 0.604f, "tangent len");
 		configParam(PBEZFREQ_PARAM,   -3.f, 3.f, 0.f, "frequency");
     configParam(MODUS_PARAM,       1.f, 4.f, 1.f, "modus");
+
+    for (int i = 0; i < numXY; i++){
+      shownHandles[i] = NAN;
+    }
+    leftExpander.producerMessage = &splineMessages[0];
+    leftExpander.consumerMessage = &splineMessages[1];
+
 	}
+
+  ~Bezosc(){
+    stopBakeWorker();
+  }
+
+  /** Switches baked mode, from the UI thread. The worker runs before the
+      audio thread sees baked mode on and is joined after it sees it off.
+  */
+  void setBaked(bool on){
+    if (on){
+      startBakeWorker();
+      baked = true;
+    }
+    else {
+      baked = false;
+      stopBakeWorker();
+    }
+  }
+
+  void startBakeWorker(){
+    if (bakeThread.joinable()){
+      return;
+    }
+    if (!bakedTables){
+      bakedTables.reset(new BakedTable[3]);
+    }
+    bakeStop = false;
+    bakeThread = std::thread(&Bezosc::bakeWorker, this);
+  }
+
+  /** A request posted meanwhile waits for the next worker. */
+  void stopBakeWorker(){
+    if (!bakeThread.joinable()){
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(bakeMutex);
+      bakeStop = true;
+    }
+    bakeCv.notify_one();
+    bakeThread.join();
+  }
  
+  /** Arranges the xy values into four segments, accounting for the modus,
+  and converts every segment to power basis,
+  B(t) = at^3 + bt^2 + ct + d.
+  The handles the modus derives are computed here and only shown on the 
+  knobs, they never feed back through the params.
+  */
+  void buildSpline(int g, const float_4* xy, int modus){
+    Vec_4 Ad, Ab, Ba, Bc, Cb, Cd, Dc, Da;
+    Vec_4 A = Vec_4(xy[2], xy[3]);
+    Vec_4 B = Vec_4(xy[8], xy[9]);
+    Vec_4 C = Vec_4(xy[14],xy[15]);
+    Vec_4 D = Vec_4(xy[20],xy[21]);
+    if(modus == 1){
+      // Independent rough mode.
+      Ad = Vec_4(xy[0], xy[1]);
+      Ab = Vec_4(xy[4], xy[5]);
+      Ba = Vec_4(xy[6], xy[7]);
+      Bc = Vec_4(xy[10],xy[11]);
+      Cb = Vec_4(xy[12],xy[13]);
+      Cd = Vec_4(xy[16],xy[17]);
+      Dc = Vec_4(xy[18],xy[19]);
+      Da = Vec_4(xy[22],xy[23]);
+    }
+    else if(modus == 2){
+      // Dependent rough mode, handles move along with knots. 
+      // Handles can be set independent.
+      Ab = Vec_4(xy[4], xy[5]).plus(A);
+      Ba = Vec_4(xy[6], xy[7]).plus(B);
+      Bc = Vec_4(xy[10],xy[11]).plus(B);
+      Cb = Vec_4(xy[12],xy[13]).plus(C);
+      Cd = Vec_4(xy[16],xy[17]).plus(C);
+      Dc = Vec_4(xy[18],xy[19]).plus(D);
+      Da = Vec_4(xy[22],xy[23]).plus(D);
+      Ad = Vec_4(xy[0], xy[1]).plus(A);
+    }
+    else if(modus == 3){    
+      // Dependent semi smooth, handles move along with knots. One handle can be set independent. 
+      // The other is only variable in length, positive as well as negative.
+      Ab = A.plus(Vec_4(xy[4], xy[5]));
+      Bc = B.plus(Vec_4(xy[10],xy[11]));
+      Cd = C.plus(Vec_4(xy[16],xy[17]));
+      Da = D.plus(Vec_4(xy[22],xy[23]));
+      Ba = B.minus((Vec_4(xy[10],xy[11]).normalize()).mult(xy[6]));
+      Cb = C.minus(Vec_4(xy[16],xy[17]).normalize()).mult(xy[12]);
+      Dc = D.minus(Vec_4(xy[22],xy[23]).normalize()).mult(xy[18]);
+      Ad = A.minus(Vec_4(xy[4], xy[5]).normalize()).mult(xy[0]);
+      if (g == 0){
+        uiHandles.set( 7, xy[6][0]);
+        uiHandles.set(13, xy[12][0]);
+        uiHandles.set(19, xy[18][0]);
+        uiHandles.set( 1, xy[0][0]);
+      }
+    }
+    else if(modus == 4){
+    // Smooth, handles move along with knots. One handle can be set independent, 
+    // the other is equal in opposite direction.
+      Ab = A.plus(Vec_4(xy[4], xy[5]));
+      Bc = B.plus(Vec_4(xy[10],xy[11]));
+      Cd = C.plus(Vec_4(xy[16],xy[17]));
+      Da = D.plus(Vec_4(xy[22],xy[23]));
+      Ba = B.minus(Vec_4(xy[10],xy[11]));
+      Cb = C.minus(Vec_4(xy[16],xy[17]));
+      Dc = D.minus(Vec_4(xy[22],xy[23]));
+      Ad = A.minus(Vec_4(xy[4], xy[5]));
+      if (g == 0){
+        uiHandles.set( 6, -xy[10][0]);
+        uiHandles.set( 7, -xy[11][0]);
+        uiHandles.set(12, -xy[16][0]);
+        uiHandles.set(13, -xy[17][0]);
+        uiHandles.set(18, -xy[22][0]);
+        uiHandles.set(19, -xy[23][0]);
+        uiHandles.set( 0, -xy[4][0]);
+        uiHandles.set( 1, -xy[5][0]);
+      }
+    };
+    Vec_4 bezier[numSegments][pointsSegment] = {
+      {A, Ab, Ba, B},
+      {B, Bc, Cb, C},
+      {C, Cd, Dc, D},
+      {D, Da, Ad, A}
+    };
+    for (int s = 0; s < numSegments; s++){
+      bezierCoefs(bezier[s], coefs[g][s]);
+    }
+    coefModus[g] = modus;
+  }
+
+  inline float_4 angle(Vec_4 a){
+    return fast ? fastAtan2(a.y, a.x) : simd::atan2(a.y, a.x);
+  }
+
+  inline float_4 length(Vec_4 a){
+    return fast ? fastHypot(a.x, a.y) : simd::sqrt(a.x * a.x + a.y * a.y);
+  }
+
+  /** Theta and length outputs th and l of the vector a, if connected. */
+  inline void polar(Vec_4 a, const bool* connected, int th, int l, float_4* v){
+    if(connected[th]){ //angle vector (x,y).
+      v[th] = angle(a);
+    }
+    if(connected[l]){  //length (x,y).
+      float_4 len = length(a);
+      v[l] = simd::ifelse(a.y < 0.f, -len, len);
+    }
+  }
+
+  /** Unscaled values of all connected outputs at (arrIdx, t) for group g. */
+  inline void evaluate(int g, float_4 arrIdx, float_4 t, const bool* connected, bool obez, bool otan, float_4* v){
+    // Every lane may sit on a different segment, pick its coefficients.
+    // Mostly all lanes share one segment and it can be indexed directly.
+    Vec_4 K[pointsSegment];
+    int seg = arrIdx[0];
+    if (simd::movemask(arrIdx == seg) == 0xf){
+      for (int j = 0; j < pointsSegment; j++){
+        K[j] = coefs[g][seg][j];
+      }
+    }
+    else {
+      for (int j = 0; j < pointsSegment; j++){
+        K[j] = coefs[g][0][j];
+      }
+      for (int s = 1; s < numSegments; s++){
+        float_4 onSegment = arrIdx == s;
+        for (int j = 0; j < pointsSegment; j++){
+          K[j] = Vec_4::ifelse(onSegment, coefs[g][s][j], K[j]);
+        }
+      }
+    }
+
+    if(obez){
+      //Position vector @ t, on bezier section, Horner's scheme.
+      //B(t) = ((at + b)t + c)t + d.
+      Vec_4 bez = bezierHorner(K, t);
+      v[OBEZX_OUTPUT] = bez.x;
+      v[OBEZY_OUTPUT] = bez.y;
+      polar(bez, connected, OBEZTH_OUTPUT, OBEZL_OUTPUT, v);
+    }
+    if(otan){
+      //Tangent vector @ t, on first derivative of bezier.
+      //B′(t) = (3at + 2b)t + c.
+      Vec_4 beztan = bezierHornerTangent(K, t);
+      v[OTANX_OUTPUT] = beztan.x;
+      v[OTANY_OUTPUT] = beztan.y;
+      polar(beztan, connected, OTANTH_OUTPUT, OTANL_OUTPUT, v);
+    }
+  }
+
+  /** Reads the shape bus, channels 1 to 16 of bus A and 1 to 8 of bus B 
+      are the xy values in knob order, for every voice. Six vector loads, 
+      channels the cable does not have are 0. Returns false if neither 
+      bus is connected.
+  */
+  bool readBus(float_4* bus){
+    const float_4 lane = float_4(0.f, 1.f, 2.f, 3.f);
+    bool connected = false;
+    for (int k = 0; k < numBus; k++){
+      Input& in = inputs[(k < 4) ? BUSA_INPUT : BUSB_INPUT];
+      int first = 4 * (k % 4);
+      bus[k] = float_4::zero();
+      if (in.isConnected()){
+        connected = true;
+        bus[k] = in.getVoltageSimd<float_4>(first);
+        if (first + 4 > in.getChannels()){
+          bus[k] = simd::ifelse(lane + first < in.getChannels(), bus[k], 0.f);
+        }
+      }
+    }
+    return connected;
+  }
+
+  /** Reads the spline inputs of group g, and the bus if not NULL, rebuilds 
+      the coefficients only if anything moved. Returns true if it did.
+  */
+  bool updateShape(int g, int c, int modus, const bool* xyConnected, const float_4* bus){
+    float_4 xy[numXY];
+    float_4 changed = float_4::zero();
+    const bool* derived = derivedHandles[modus - 1];
+    for (int i = 0; i < numXY; i++){
+      xy[i] = params[PBEZ_PARAM + i].getValue();
+      if (bus){
+        xy[i] += bus[i / 4][i % 4];
+      }
+      if (xyConnected[i]){
+        xy[i] += inputs[IBEZ_INPUT + i].getPolyVoltageSimd<float_4>(c);
+      }
+      if (!derived[i]){
+        changed |= (xy[i] != xyCache[g][i]);
+      }
+    }
+    bool moved = simd::movemask(changed) || modus != coefModus[g];
+    if (moved){
+      buildSpline(g, xy, modus);
+      for (int i = 0; i < numXY; i++){
+        xyCache[g][i] = xy[i];
+      }
+      // Also when not in use, a later switch to constant speed or baked 
+      // mode must not pick up a stale shape.
+      arcTables[g].dirty = true;
+      if (g == 0){
+        bakePending = true;
+      }
+    }
+    return moved;
+  }
+
+  /** Takes the spline of the module on the left for group g, rebuilds the
+      coefficients only if a new one arrived. Returns true if it did.
+  */
+  bool followSpline(int g, const SplineMessage* message){
+    bool moved = (
+         message->serial != followSerial[g]
+      || leftExpander.moduleId != followSource[g]
+      || coefModus[g] != 0
+    );
+    if (moved){
+      for (int s = 0; s < numSegments; s++){
+        Vec_4 P[pointsSegment];
+        for (int j = 0; j < pointsSegment; j++){
+          P[j] = Vec_4(message->x[s][j], message->y[s][j]);
+        }
+        bezierCoefs(P, coefs[g][s]);
+      }
+      followSerial[g] = message->serial;
+      followSource[g] = leftExpander.moduleId;
+      // No modus, the knobs rebuild the spline once following stops.
+      coefModus[g] = 0;
+      arcTables[g].dirty = true;
+      if (g == 0){
+        bakePending = true;
+      }
+    }
+    return moved;
+  }
+
+  /** Passes the spline of voice 1 to a Bezosc on the right, only when it
+      moved or the neighbour is new.
+  */
+  void publishSpline(bool moved){
+    SplineMessage* message = splineTarget(this);
+    if (!message){
+      // Passed again once the neighbour follows.
+      publishTarget = -1;
+      return;
+    }
+    if (!moved && rightExpander.moduleId == publishTarget){
+      return;
+    }
+    for (int s = 0; s < numSegments; s++){
+      Vec_4 P[pointsSegment];
+      bezierPoints(coefs[0][s], P);
+      for (int j = 0; j < pointsSegment; j++){
+        message->x[s][j] = P[j].x[0];
+        message->y[s][j] = P[j].y[0];
+      }
+    }
+    // 0 is no spline yet.
+    if (++publishSerial == 0){
+      publishSerial = 1;
+    }
+    message->serial = publishSerial;
+    publishTarget = rightExpander.moduleId;
+    splineFlip(this);
+  }
+
+  /** Copies the control points and position of voice 1 for the display.
+      Only called once per UI frame, when the widget asks for it.
+  */
+  void publishDisplay(){
+    DisplaySnapshot snapshot;
+    for (int s = 0; s < numSegments; s++){
+      // Back from power basis to the Bezier control points.
+      Vec_4 P[pointsSegment];
+      bezierPoints(coefs[0][s], P);
+      for (int j = 0; j < pointsSegment; j++){
+        snapshot.points[s][j] = Vec(P[j].x[0], P[j].y[0]);
+      }
+    }
+    float phase = steps[0][0];
+    snapshot.tau = arcLength ? arcTables[0].map(phase / numSegments)[0] : phase;
+    displayBuffer.push(snapshot);
+  }
+
+  /** Scalar value of output i for position bez and tangent beztan, unscaled. */
+  static float outputValue(int i, Vec bez, Vec beztan){
+    switch (i){
+      case OBEZX_OUTPUT: return bez.x;
+      case OBEZY_OUTPUT: return bez.y;
+      case OBEZTH_OUTPUT: return std::atan2(bez.y, bez.x);
+      case OBEZL_OUTPUT: return (bez.y < 0.f) ? -bez.norm() : bez.norm();
+      case OTANX_OUTPUT: return beztan.x;
+      case OTANY_OUTPUT: return beztan.y;
+      case OTANTH_OUTPUT: return std::atan2(beztan.y, beztan.x);
+      case OTANL_OUTPUT: return (beztan.y < 0.f) ? -beztan.norm() : beztan.norm();
+    }
+    return 0.f;
+  }
+
+  /** Worker thread, renders one cycle of every requested output into a
+      table. The audio thread posts without locking or notifying, the 
+      worker looks for a request every bakePollMs while it runs, that is 
+      while baked mode is on. The mutex and condition variable only 
+      serve stopping it.
+  */
+  void bakeWorker(){
+    MipMapBaker baker;
+    std::unique_lock<std::mutex> lock(bakeMutex);
+    while (true){
+      bakeCv.wait_for(lock, std::chrono::milliseconds(bakePollMs), [&]{return bakeStop || bakeRequestState.load() == 1;});
+      if (bakeStop){
+        break;
+      }
+      if (bakeRequestState.load() != 1){
+        continue;
+      }
+      bakeRequestState.store(2);
+      BakeRequest request = bakeRequest;
+      bakeRequestState.store(0);
+      lock.unlock();
+
+      // Spline parameter of every table entry, at equidistant arc length
+      // for constant speed traversal.
+      std::vector<float> tau(MipMapTable::size);
+      for (int j = 0; j < MipMapTable::size; j++){
+        tau[j] = (float) j * numSegments / MipMapTable::size;
+      }
+      if (request.arcLength){
+        const int fine = 16 * MipMapTable::size;
+        std::vector<float> cumulative(fine + 1, 0.f);
+        for (int k = 0; k < fine; k++){
+          float u = (k + 0.5f) * numSegments / fine;
+          int seg = u;
+          float t = u - seg;
+          Vec beztan(bezierHornerTangent(request.coefs[0][seg], t), bezierHornerTangent(request.coefs[1][seg], t));
+          cumulative[k + 1] = cumulative[k] + beztan.norm();
+        }
+        float total = cumulative[fine];
+        int k = 0;
+        for (int j = 0; j < MipMapTable::size && total > 0.f; j++){
+          float target = total * j / MipMapTable::size;
+          while (k < fine - 1 && cumulative[k + 1] < target){
+            k++;
+          }
+          float a = cumulative[k];
+          float b = cumulative[k + 1];
+          float frac = (b > a) ? clamp((target - a) / (b - a), 0.f, 1.f) : 0.f;
+          tau[j] = (k + frac) * numSegments / fine;
+        }
+      }
+
+      BakedTable& table = bakedTables[bakedBack];
+      for (int i = 0; i < NUM_OUTPUTS; i++){
+        table.active[i] = request.active[i];
+        if (!request.active[i]){
+          continue;
+        }
+        for (int j = 0; j < MipMapTable::size; j++){
+          float u = tau[j];
+          int seg = std::min((int) u, numSegments - 1);
+          float t = u - seg;
+          const float* X = request.coefs[0][seg];
+          const float* Y = request.coefs[1][seg];
+          Vec bez(bezierHorner(X, t), bezierHorner(Y, t));
+          Vec beztan(bezierHornerTangent(X, t), bezierHornerTangent(Y, t));
+          baker.cycle[j] = outputValue(i, bez, beztan);
+        }
+        baker.bake(table.waves[i]);
+      }
+      table.serial = request.serial;
+      bakedBack = bakedMiddle.exchange(bakedBack | bakedFresh) & 3;
+
+      lock.lock();
+    }
+  }
+
+  /** Waits for the shape of voice 1 to settle, then posts it to the worker. */
+  void trackBake(bool moved, const bool* connected, float sampleRate){
+    if (arcLength != bakeArcLength){
+      bakeArcLength = arcLength;
+      moved = true;
+    }
+    for (int i = 0; i < NUM_OUTPUTS; i++){
+      if (connected[i] != bakeActive[i]){
+        bakeActive[i] = connected[i];
+        moved = true;
+      }
+    }
+    if (moved){
+      bakeSettle = 0;
+      bakePending = true;
+      return;
+    }
+    if (!bakePending || ++bakeSettle < bakeSettleTime * sampleRate || bakeRequestState.load() != 0){
+      return;
+    }
+    for (int s = 0; s < numSegments; s++){
+      for (int j = 0; j < pointsSegment; j++){
+        bakeRequest.coefs[0][s][j] = coefs[0][s][j].x[0];
+        bakeRequest.coefs[1][s][j] = coefs[0][s][j].y[0];
+      }
+    }
+    for (int i = 0; i < NUM_OUTPUTS; i++){
+      bakeRequest.active[i] = connected[i];
+    }
+    bakeRequest.arcLength = arcLength;
+    bakeRequest.serial = ++bakeSerial;
+    // No lock on the audio thread, the worker picks it up on its next look.
+    bakeRequestState.store(1);
+    bakePending = false;
+  }
+
+  /** Picks up a freshly baked table, true if it matches the current shape. */
+  bool bakeReady(const bool* connected){
+    if (bakedMiddle.load() & bakedFresh){
+      bakedFront = bakedMiddle.exchange(bakedFront) & 3;
+    }
+    const BakedTable& table = bakedTables[bakedFront];
+    if (bakePending || table.serial != bakeSerial){
+      return false;
+    }
+    for (int i = 0; i < NUM_OUTPUTS; i++){
+      if (connected[i] && !table.active[i]){
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /** Wavetable playback of group g, the mip level follows each voice's pitch. */
+  void playBaked(int g, int c, float_4 freq, float sampleTime, const bool* connected, const float* scale){
+    float_4& step = steps[g];
+    step += sampleTime * freq * numSegments;
+    float_4 arrIdx = simd::floor(step);
+    step = simd::ifelse(arrIdx >= numSegments, step - arrIdx, step);
+    float_4 phase = step / numSegments;
+
+    int level[4];
+    for (int l = 0; l < 4; l++){
+      level[l] = MipMapTable::level(freq[l], sampleTime);
+    }
+    const BakedTable& table = bakedTables[bakedFront];
+    for (int i = 0; i < NUM_OUTPUTS; i++){
+      if (connected[i]){
+        float_4 out;
+        for (int l = 0; l < 4; l++){
+          out[l] = table.waves[i].read(level[l], phase[l]);
+        }
+        outputs[i].setVoltageSimd(out * scale[i], c);
+      }
+    }
+  }
+
 	void process(const ProcessArgs& args) override {
+    // Tells the left neighbour whether to pass its spline.
+    for (int i = 0; i < 2; i++){
+      splineMessages[i].follows.store(followLeft, std::memory_order_relaxed);
+    }
+    bool connected[NUM_OUTPUTS];
+    for (int i = 0; i < NUM_OUTPUTS; i++){
+      connected[i] = outputs[i].isConnected();
+    }
     bool obez = (  
-         outputs[OBEZX_OUTPUT].isConnected()  || outputs[OBEZY_OUTPUT].isConnected()
-      || outputs[OBEZTH_OUTPUT].isConnected() || outputs[OBEZL_OUTPUT].isConnected()
+         connected[OBEZX_OUTPUT]  || connected[OBEZY_OUTPUT]
+      || connected[OBEZTH_OUTPUT] || connected[OBEZL_OUTPUT]
     );
     bool otan = (  
-         outputs[OTANX_OUTPUT].isConnected()  || outputs[OTANY_OUTPUT].isConnected()
-      || outputs[OTANTH_OUTPUT].isConnected() || outputs[OTANL_OUTPUT].isConnected()
+         connected[OTANX_OUTPUT]  || connected[OTANY_OUTPUT]
+      || connected[OTANTH_OUTPUT] || connected[OTANL_OUTPUT]
     );
+    const SplineMessage* shared = followLeft ? splineSource(this) : NULL;
+    bool publishing = splineTarget(this);
+    bool shapeMoved = false;
+    int modus = params[MODUS_PARAM].getValue();
+    if(modus != oldModus){
+      for (int i = 0; i < NUM_LIGHTS; i++){
+        uiLights.set(i, theLeds[modus-1][i]);
+      }
+      // Handles that are no longer derived show their own knob again.
+      uiHandles.invalidate();
+      oldModus = modus;
+    }
     if (obez || otan){
-      int modus = params[MODUS_PARAM].getValue();
-      if(modus != oldModus){
-        for (int i = 0; i < NUM_LIGHTS; i++){
-          lights[LLED_LIGHT + i].setBrightness(theLeds[modus-1][i]);
+      if (oversample != decimatorFactor){
+        for (int g = 0; g < 4; g++){
+          for (int i = 0; i < NUM_OUTPUTS; i++){
+            decimators[g][i].reset();
+          }
         }
-        oldModus = modus;
+        decimatorFactor = oversample;
       }
-      // get all spline input values and arrange it into four segements, 
-      // accounting for the current mode.
-      float xy[numXY];
+      // The widest polyphonic input sets the number of voices, 
+      // voices are evaluated four at a time.
+      int channels = std::max(1, inputs[IBEZFREQ_INPUT].getChannels());
+      bool xyConnected[numXY];
+      // Baking needs one shape for all voices.
+      bool bakeable = baked;
       for (int i = 0; i < numXY; i++){
-        xy[i] = rack::simd::ifelse(
-           inputs[IBEZ_INPUT + i].isConnected()
-          ,params[PBEZ_PARAM + i].getValue() + inputs[IBEZ_INPUT + i].getVoltage()
-          ,params[PBEZ_PARAM + i].getValue()
-        );
-      }
-      Vec Ad, Ab, Ba, Bc, Cb, Cd, Dc, Da;
-      Vec A = Vec(xy[2], xy[3]);
-      Vec B = Vec(xy[8], xy[9]);
-      Vec C = Vec(xy[14],xy[15]);
-      Vec D = Vec(xy[20],xy[21]);
-      if(modus == 1){
-        // Independent rough mode.
-        Ad = Vec(xy[0], xy[1]);
-        Ab = Vec(xy[4], xy[5]);
-        Ba = Vec(xy[6], xy[7]);
-        Bc = Vec(xy[10],xy[11]);
-        Cb = Vec(xy[12],xy[13]);
-        Cd = Vec(xy[16],xy[17]);
-        Dc = Vec(xy[18],xy[19]);
-        Da = Vec(xy[22],xy[23]);
-      }
-      else if(modus == 2){
-        // Dependent rough mode, handles move along with knots. 
-        // Handles can be set independent.
-        Ab = Vec(xy[4], xy[5]).plus(A);
-        Ba = Vec(xy[6], xy[7]).plus(B);
-        Bc = Vec(xy[10],xy[11]).plus(B);
-        Cb = Vec(xy[12],xy[13]).plus(C);
-        Cd = Vec(xy[16],xy[17]).plus(C);
-        Dc = Vec(xy[18],xy[19]).plus(D);
-        Da = Vec(xy[22],xy[23]).plus(D);
-        Ad = Vec(xy[0], xy[1]).plus(A);
-      }
-      else if(modus == 3){    
-        // Dependent semi smooth, handles move along with knots. One handle can be set independent. 
-        // The other is only variable in length, positive as well as negative.
-        Ab = A.plus(Vec(xy[4], xy[5]));
-        Bc = B.plus(Vec(xy[10],xy[11]));
-        Cd = C.plus(Vec(xy[16],xy[17]));
-        Da = D.plus(Vec(xy[22],xy[23]));
-        Ba = B.minus((Vec(xy[10],xy[11]).normalize()).mult(xy[6]));
-        Cb = C.minus(Vec(xy[16],xy[17]).normalize()).mult(xy[12]);
-        Dc = D.minus(Vec(xy[22],xy[23]).normalize()).mult(xy[18]);
-        Ad = A.minus(Vec(xy[4], xy[5]).normalize()).mult(xy[0]);
-        params[PBEZ_PARAM +  7].setValue(xy[6]);
-        params[PBEZ_PARAM + 13].setValue(xy[12]);
-        params[PBEZ_PARAM + 19].setValue(xy[18]);
-        params[PBEZ_PARAM +  1].setValue(xy[0]);
-      }
-      else if(modus == 4){
-      // Smooth, handles move along with knots. One handle can be set independent, 
-      // the other is equal in opposite direction.
-        Ab = A.plus(Vec(xy[4], xy[5]));
-        Bc = B.plus(Vec(xy[10],xy[11]));
-        Cd = C.plus(Vec(xy[16],xy[17]));
-        Da = D.plus(Vec(xy[22],xy[23]));
-        Ba = B.minus(Vec(xy[10],xy[11]));
-        Cb = C.minus(Vec(xy[16],xy[17]));
-        Dc = D.minus(Vec(xy[22],xy[23]));
-        Ad = A.minus(Vec(xy[4], xy[5]));
-        params[PBEZ_PARAM +  6].setValue(-xy[10]);
-        params[PBEZ_PARAM +  7].setValue(-xy[11]);
-        params[PBEZ_PARAM + 12].setValue(-xy[16]);
-        params[PBEZ_PARAM + 13].setValue(-xy[17]);
-        params[PBEZ_PARAM + 18].setValue(-xy[22]);
-        params[PBEZ_PARAM + 19].setValue(-xy[23]);
-        params[PBEZ_PARAM +  0].setValue(-xy[4]);
-        params[PBEZ_PARAM +  1].setValue(-xy[5]);
-      };
-      Vec bezier[numSegments][pointsSegment] = {
-        {A, Ab, Ba, B},
-        {B, Bc, Cb, C},
-        {C, Cd, Dc, D},
-        {D, Da, Ad, A}
-      };
-      
-      float pitch = rack::simd::ifelse(
-         inputs[IBEZFREQ_INPUT].isConnected()
-        ,params[PBEZFREQ_PARAM].getValue() + inputs[IBEZFREQ_INPUT].getVoltage()
-        ,params[PBEZFREQ_PARAM].getValue()
-      );
+        xyConnected[i] = inputs[IBEZ_INPUT + i].isConnected();
+        channels = std::max(channels, inputs[IBEZ_INPUT + i].getChannels());
+        if (inputs[IBEZ_INPUT + i].getChannels() > 1){
+          bakeable = false;
+        }
+      }
+      if (!bakeable){
+        bakePending = true;
+      }
+      float_4 bus[numBus];
+      bool busConnected = readBus(bus);
+      bool playingBaked = false;
+      float scale[NUM_OUTPUTS];
+      for (int i = 0; i < NUM_OUTPUTS; i++){
+        scale[i] = params[PBEZSCALEX_PARAM + i].getValue();
+      }
+      // Oversampled only x and y of position and tangent run at the high 
+      // rate and are decimated, theta and length follow from the 
+      // decimated x and y, one atan2 and hypot per sample, not per 
+      // oversampled sample, and no decimators of their own.
+      bool rateConnected[NUM_OUTPUTS];
+      for (int i = 0; i < NUM_OUTPUTS; i++){
+        rateConnected[i] = connected[i];
+      }
+      if (oversample > 1){
+        rateConnected[OBEZX_OUTPUT] = rateConnected[OBEZY_OUTPUT] = obez;
+        rateConnected[OTANX_OUTPUT] = rateConnected[OTANY_OUTPUT] = otan;
+        rateConnected[OBEZTH_OUTPUT] = rateConnected[OBEZL_OUTPUT] = false;
+        rateConnected[OTANTH_OUTPUT] = rateConnected[OTANL_OUTPUT] = false;
+      }
 
-      float freq = dsp::FREQ_C4 * powf(2.0f, pitch);
-      steps += args.sampleTime * freq * numSegments;
-      int arrIdx = floor(steps);
-      float t = steps - arrIdx;
-
-      if (arrIdx >= numSegments){
-        arrIdx = 0;
-        steps = t;
-      }
-
-      float t2 = t * t;
-      float t3 = t2 * t;
-      float tm = 1 - t;
-      float tm2 = tm * tm;
-      float tm3 = tm2 * tm;
-
-      if(obez){
-        //Position vector @ t, on bezier section.
-        //B(t) = (1−t)^3P0 + 3(1−t)^2tP1 + 3(1−t)t^2P2 + t^3P3.
-        Vec b1 = bezier[arrIdx][0].mult(tm3);
-        Vec b2 = bezier[arrIdx][1].mult(3*tm2*t);
-        Vec b3 = bezier[arrIdx][2].mult(3*tm*t2);
-        Vec b4 = bezier[arrIdx][3].mult(t3);
-        Vec bez = b1.plus(b2).plus(b3).plus(b4);
-        if(outputs[OBEZX_OUTPUT].isConnected()){
-          outputs[OBEZX_OUTPUT].setVoltage(bez.x * params[PBEZSCALEX_PARAM].getValue());
+      for (int c = 0; c < channels; c += 4){
+        int g = c / 4;
+        bool moved = shared ? followSpline(g, shared) : updateShape(g, c, modus, xyConnected, busConnected ? bus : NULL);
+        if (g == 0){
+          shapeMoved = moved;
         }
-        if(outputs[OBEZY_OUTPUT].isConnected()){
-          outputs[OBEZY_OUTPUT].setVoltage(bez.y * params[PBEZSCALEY_PARAM].getValue());
+        if (arcLength){
+          arcTables[g].update(moved, coefs[g]);
         }
-        if(outputs[OBEZTH_OUTPUT].isConnected()){ //angle vector (x,y).
-          outputs[OBEZTH_OUTPUT].setVoltage(atan2(bez.y, bez.x) * params[PBEZSCALETH_PARAM].getValue());
+        if (g == 0 && bakeable){
+          trackBake(moved, connected, args.sampleRate);
+          playingBaked = bakeReady(connected);
         }
-        if(outputs[OBEZL_OUTPUT].isConnected()){  //length (x,y).
-          float v = sqrt(pow(bez.x,2)+pow(bez.y,2)) * params[PBEZSCALEL_PARAM].getValue();
-          if(sgn(bez.y) == -1){v = -v;}
-          outputs[OBEZL_OUTPUT].setVoltage(v);
+        
+        float_4 pitch = params[PBEZFREQ_PARAM].getValue();
+        if (inputs[IBEZFREQ_INPUT].isConnected()){
+          pitch += inputs[IBEZFREQ_INPUT].getPolyVoltageSimd<float_4>(c);
         }
-      }
-      if(otan){
-        //Tangent vector @ t, on first derivative of bezier.
-        //B′(t)= 3(1−t)^2(P1−P0) + 6(1−t)t(P2−P1) + 3t^2(P3−P2).
-        Vec c1 = (bezier[arrIdx][1].minus(bezier[arrIdx][0])).mult(3 * tm2);
-        Vec c2 = (bezier[arrIdx][2].minus(bezier[arrIdx][1])).mult(6 * tm * t);
-        Vec c3 = (bezier[arrIdx][3].minus(bezier[arrIdx][2])).mult(3 * t2);
-        Vec beztan = c1.plus(c2).plus(c3);
-        if(outputs[OTANX_OUTPUT].isConnected()){
-          outputs[OTANX_OUTPUT].setVoltage(beztan.x * params[PTANSCALEX_PARAM].getValue());
+
+        // Phase and spline run at the oversampled rate.
+        float_4 freq = dsp::FREQ_C4 * simd::pow(2.0f, pitch);
+        if (playingBaked){
+          playBaked(g, c, freq, args.sampleTime, connected, scale);
+          continue;
         }
-        if(outputs[OTANY_OUTPUT].isConnected()){
-          outputs[OTANY_OUTPUT].setVoltage(beztan.y * params[PTANSCALEY_PARAM].getValue());
+        float_4 delta = args.sampleTime * freq * numSegments / oversample;
+        float_4& step = steps[g];
+        float_4 v[NUM_OUTPUTS][CascadeDecimator<float_4>::maxFactor];
+        float_4 vs[NUM_OUTPUTS] = {};
+        for (int k = 0; k < oversample; k++){
+          step += delta;
+          float_4 arrIdx = simd::floor(step);
+          float_4 t = step - arrIdx;
+
+          float_4 wrap = arrIdx >= numSegments;
+          arrIdx = simd::ifelse(wrap, 0.f, arrIdx);
+          step = simd::ifelse(wrap, t, step);
+
+          if (arcLength){
+            float_4 tau = arcTables[g].map(step / numSegments);
+            arrIdx = simd::fmin(simd::floor(tau), numSegments - 1);
+            t = tau - arrIdx;
+          }
+
+          evaluate(g, arrIdx, t, rateConnected, obez, otan, vs);
+          for (int i = 0; i < NUM_OUTPUTS; i++){
+            if (rateConnected[i]){
+              v[i][k] = vs[i];
+            }
+          }
         }
-        if(outputs[OTANTH_OUTPUT].isConnected()){ //angle of tangent vector.
-          outputs[OTANTH_OUTPUT].setVoltage(atan2(beztan.y, beztan.x) * params[PTANSCALETH_PARAM].getValue());
+
+        float_4 out[NUM_OUTPUTS];
+        for (int i = 0; i < NUM_OUTPUTS; i++){
+          if (rateConnected[i]){
+            out[i] = decimators[g][i].process(v[i], oversample);
+          }
         }
-        if(outputs[OTANL_OUTPUT].isConnected()){ //length of tangent vector.
-          float v = sqrt(pow(beztan.x,2)+pow(beztan.y,2)) * params[PTANSCALEL_PARAM].getValue();
-          if(sgn(beztan.y) == -1){v = -v;}
-          outputs[OTANL_OUTPUT].setVoltage(v);
+        if (oversample > 1){
+          if (obez){
+            polar(Vec_4(out[OBEZX_OUTPUT], out[OBEZY_OUTPUT]), connected, OBEZTH_OUTPUT, OBEZL_OUTPUT, out);
+          }
+          if (otan){
+            polar(Vec_4(out[OTANX_OUTPUT], out[OTANY_OUTPUT]), connected, OTANTH_OUTPUT, OTANL_OUTPUT, out);
+          }
         }
+        for (int i = 0; i < NUM_OUTPUTS; i++){
+          if (connected[i]){
+            outputs[i].setVoltageSimd(out[i] * scale[i], c);
+          }
+        }
+      }
+      for (int i = 0; i < NUM_OUTPUTS; i++){
+        outputs[i].setChannels(channels);
+      }
+    }
+    else if (displayRequest.load() || publishing){
+      // Nothing to render, still let the display and the right neighbour
+      // follow the knobs.
+      bool xyConnected[numXY];
+      for (int i = 0; i < numXY; i++){
+        xyConnected[i] = inputs[IBEZ_INPUT + i].isConnected();
+      }
+      float_4 bus[numBus];
+      bool busConnected = readBus(bus);
+      if (shared){
+        shapeMoved = followSpline(0, shared);
       }
+      else {
+        shapeMoved = updateShape(0, 0, modus, xyConnected, busConnected ? bus : NULL);
+      }
+    }
+    if (publishing){
+      publishSpline(shapeMoved);
     }
+    if (uiClock.process(args.sampleRate)){
+      uiLights.flush([&](int i, float v){
+        lights[LLED_LIGHT + i].setBrightness(v);
+      });
+      const bool* derived = derivedHandles[modus - 1];
+      uiHandles.flush([&](int i, float v){
+        shownHandles[i] = derived[i] ? v : NAN;
+      });
+    }
+    if (displayRequest.load() && !displayBuffer.full()){
+      publishDisplay();
+      displayRequest.store(false);
+    }
+  }
+
+  json_t* dataToJson() override {
+    json_t* rootJ = json_object();
+    json_object_set_new(rootJ, "oversample", json_integer(oversample));
+    json_object_set_new(rootJ, "baked", json_boolean(baked));
+    json_object_set_new(rootJ, "fast", json_boolean(fast));
+    json_object_set_new(rootJ, "arcLength", json_boolean(arcLength));
+    json_object_set_new(rootJ, "followLeft", json_boolean(followLeft));
+    json_object_set_new(rootJ, "uiRate", uiClock.toJson());
+    return rootJ;
+  }
+
+  void dataFromJson(json_t* rootJ) override {
+    json_t* oversampleJ = json_object_get(rootJ, "oversample");
+    if (oversampleJ){
+      // Only the factors the decimator cascade has stages for, anything
+      // else from an edited patch plays at 1x.
+      int factor = json_integer_value(oversampleJ);
+      oversample = (factor == 2 || factor == 4 || factor == 8) ? factor : 1;
+    }
+    json_t* bakedJ = json_object_get(rootJ, "baked");
+    if (bakedJ){
+      setBaked(json_is_true(bakedJ));
+    }
+    json_t* fastJ = json_object_get(rootJ, "fast");
+    if (fastJ){
+      fast = json_is_true(fastJ);
+    }
+    json_t* arcLengthJ = json_object_get(rootJ, "arcLength");
+    if (arcLengthJ){
+      arcLength = json_is_true(arcLengthJ);
+    }
+    json_t* followLeftJ = json_object_get(rootJ, "followLeft");
+    if (followLeftJ){
+      followLeft = json_is_true(followLeftJ);
+    }
+    uiClock.fromJson(json_object_get(rootJ, "uiRate"));
   }
 };
 
 
+/** Closed spline of voice 1 with its handles, drawn into the cached 
+    framebuffer of BezoscDisplay. 
+*/
+struct BezoscShape : Widget {
+  // Visible range in volts, both directions.
+  static constexpr float range = 12.f;
+
+  Vec points[Bezosc::numSegments][Bezosc::pointsSegment];
+  bool valid = false;
+
+  Vec toBox(Vec p){
+    return Vec(box.size.x * (0.5f + p.x / (2.f * range)), box.size.y * (0.5f - p.y / (2.f * range)));
+  }
+
+  void draw(const DrawArgs& args) override {
+    nvgBeginPath(args.vg);
+    nvgRoundedRect(args.vg, 0.f, 0.f, box.size.x, box.size.y, 3.f);
+    nvgFillColor(args.vg, nvgRGBA(0x10, 0x10, 0x10, 0xc0));
+    nvgFill(args.vg);
+    if (!valid){
+      return;
+    }
+    nvgScissor(args.vg, 0.f, 0.f, box.size.x, box.size.y);
+
+    // handles
+    nvgBeginPath(args.vg);
+    for (int s = 0; s < Bezosc::numSegments; s++){
+      Vec* P = points[s];
+      Vec p0 = toBox(P[0]), p1 = toBox(P[1]), p2 = toBox(P[2]), p3 = toBox(P[3]);
+      nvgMoveTo(args.vg, p0.x, p0.y);
+      nvgLineTo(args.vg, p1.x, p1.y);
+      nvgMoveTo(args.vg, p3.x, p3.y);
+      nvgLineTo(args.vg, p2.x, p2.y);
+    }
+    nvgStrokeColor(args.vg, nvgRGBA(0xd0, 0xd0, 0xc0, 0x80));
+    nvgStrokeWidth(args.vg, 0.75f);
+    nvgStroke(args.vg);
+    for (int s = 0; s < Bezosc::numSegments; s++){
+      for (int j = 1; j < 3; j++){
+        Vec h = toBox(points[s][j]);
+        nvgBeginPath(args.vg);
+        nvgCircle(args.vg, h.x, h.y, 1.5f);
+        nvgFillColor(args.vg, nvgRGBA(0xd0, 0xd0, 0xc0, 0xc0));
+        nvgFill(args.vg);
+      }
+    }
+
+    // spline
+    nvgBeginPath(args.vg);
+    Vec start = toBox(points[0][0]);
+    nvgMoveTo(args.vg, start.x, start.y);
+    for (int s = 0; s < Bezosc::numSegments; s++){
+      Vec* P = points[s];
+      Vec p1 = toBox(P[1]), p2 = toBox(P[2]), p3 = toBox(P[3]);
+      nvgBezierTo(args.vg, p1.x, p1.y, p2.x, p2.y, p3.x, p3.y);
+    }
+    nvgStrokeColor(args.vg, nvgRGB(0x00, 0xc8, 0xd0));
+    nvgStrokeWidth(args.vg, 1.5f);
+    nvgStroke(args.vg);
+
+    // knots
+    for (int s = 0; s < Bezosc::numSegments; s++){
+      Vec k = toBox(points[s][0]);
+      nvgBeginPath(args.vg);
+      nvgCircle(args.vg, k.x, k.y, 2.f);
+      nvgFillColor(args.vg, nvgRGB(0x00, 0xc8, 0xd0));
+      nvgFill(args.vg);
+    }
+    nvgResetScissor(args.vg);
+  }
+};
+
+/** On-panel display. Asks the module for one snapshot per frame, only 
+    redraws the cached shape when the control points changed. The position
+    dot is drawn on top, every frame.
+*/
+struct BezoscDisplay : Widget {
+  Bezosc* module;
+  FramebufferWidget* framebuffer;
+  BezoscShape* shape;
+  Vec position;
+  bool hasPosition = false;
+
+  BezoscDisplay(Bezosc* module, Vec pos, Vec size) : module(module) {
+    box.pos = pos;
+    box.size = size;
+    framebuffer = new FramebufferWidget;
+    framebuffer->box.size = size;
+    shape = new BezoscShape;
+    shape->box.size = size;
+    framebuffer->addChild(shape);
+    addChild(framebuffer);
+  }
+
+  void step() override {
+    if (module){
+      bool fresh = false;
+      Bezosc::DisplaySnapshot snapshot;
+      while (!module->displayBuffer.empty()){
+        snapshot = module->displayBuffer.shift();
+        fresh = true;
+      }
+      if (fresh){
+        bool changed = !shape->valid;
+        for (int s = 0; s < Bezosc::numSegments; s++){
+          for (int j = 0; j < Bezosc::pointsSegment; j++){
+            changed |= !snapshot.points[s][j].isEqual(shape->points[s][j]);
+            shape->points[s][j] = snapshot.points[s][j];
+          }
+        }
+        if (changed){
+          shape->valid = true;
+          framebuffer->dirty = true;
+        }
+        // de Casteljau on the control points of the current segment.
+        int seg = clamp((int) snapshot.tau, 0, Bezosc::numSegments - 1);
+        float t = clamp(snapshot.tau - seg, 0.f, 1.f);
+        const Vec* P = shape->points[seg];
+        float X[Bezosc::pointsSegment];
+        float Y[Bezosc::pointsSegment];
+        for (int j = 0; j < Bezosc::pointsSegment; j++){
+          X[j] = P[j].x;
+          Y[j] = P[j].y;
+        }
+        position = shape->toBox(Vec(bezierPoint(X, t), bezierPoint(Y, t)));
+        hasPosition = true;
+      }
+      module->displayRequest.store(true);
+    }
+    Widget::step();
+  }
+
+  void draw(const DrawArgs& args) override {
+    Widget::draw(args);
+    if (hasPosition){
+      nvgScissor(args.vg, 0.f, 0.f, box.size.x, box.size.y);
+      nvgBeginPath(args.vg);
+      nvgCircle(args.vg, position.x, position.y, 3.f);
+      nvgFillColor(args.vg, nvgRGB(0xff, 0xff, 0xff));
+      nvgFill(args.vg);
+      nvgResetScissor(args.vg);
+    }
+  }
+};
+
 struct BezoscWidget : ModuleWidget {
+  typedef ShownValueKnob<LargePaleHoleKnob> HandleKnob;
+
+  /** Handle knob i, draws the handle the module derived in modus 3 and 4. */
+  HandleKnob* createHandleKnob(Vec pos, Bezosc* module, int i){
+    HandleKnob* knob = createParamCentered<HandleKnob>(pos, module, Bezosc::PBEZ_PARAM + i);
+    knob->shown = module ? &module->shownHandles[i] : NULL;
+    return knob;
+  }
+
 	BezoscWidget(Bezosc* module) {
 		setModule(module);
 		setPanel(APP->window->loadSvg(asset::plugin(pluginInstance, "res/bezosc.svg")));
@@ -274,33 +1235,33 @@ struct BezoscWidget : ModuleWidget {
 		addChild(createWidget<ScrewSilver>(Vec(RACK_GRID_WIDTH, RACK_GRID_HEIGHT - RACK_GRID_WIDTH)));
 		addChild(createWidget<ScrewSilver>(Vec(box.size.x - 2 * RACK_GRID_WIDTH, RACK_GRID_HEIGHT - RACK_GRID_WIDTH)));
 
-		addParam(createParamCentered<LargePaleHoleKnob>(mm2px(Vec( 25.934,  16.068)), module, Bezosc::PBEZ_PARAM +  0));
-		addParam(createParamCentered<LargePaleHoleKnob>(mm2px(Vec( 39.983,  16.068)), module, Bezosc::PBEZ_PARAM +  1));
+		addParam(createHandleKnob(mm2px(Vec( 25.934,  16.068)), module, 0));
+		addParam(createHandleKnob(mm2px(Vec( 39.983,  16.068)), module, 1));
 		addParam(createParamCentered<LargeCyanHoleKnob>(mm2px(Vec( 53.726,  16.068)), module, Bezosc::PBEZ_PARAM +  2));
 		addParam(createParamCentered<LargeCyanHoleKnob>(mm2px(Vec( 67.907,  16.068)), module, Bezosc::PBEZ_PARAM +  3));
-		addParam(createParamCentered<LargePaleHoleKnob>(mm2px(Vec( 81.810,  16.068)), module, Bezosc::PBEZ_PARAM +  4));
-		addParam(createParamCentered<LargePaleHoleKnob>(mm2px(Vec( 95.847,  16.068)), module, Bezosc::PBEZ_PARAM +  5));
+		addParam(createHandleKnob(mm2px(Vec( 81.810,  16.068)), module, 4));
+		addParam(createHandleKnob(mm2px(Vec( 95.847,  16.068)), module, 5));
  
-    addParam(createParamCentered<LargePaleHoleKnob>(mm2px(Vec(108.017,  29.299)), module, Bezosc::PBEZ_PARAM +  6));
-    addParam(createParamCentered<LargePaleHoleKnob>(mm2px(Vec(108.017,  43.336)), module, Bezosc::PBEZ_PARAM +  7));
+    addParam(createHandleKnob(mm2px(Vec(108.017,  29.299)), module, 6));
+    addParam(createHandleKnob(mm2px(Vec(108.017,  43.336)), module, 7));
     addParam(createParamCentered<LargeCyanHoleKnob>(mm2px(Vec(108.017,  57.239)), module, Bezosc::PBEZ_PARAM +  8));
     addParam(createParamCentered<LargeCyanHoleKnob>(mm2px(Vec(108.017,  71.420)), module, Bezosc::PBEZ_PARAM +  9));
-    addParam(createParamCentered<LargePaleHoleKnob>(mm2px(Vec(108.017,  85.163)), module, Bezosc::PBEZ_PARAM + 10));
-    addParam(createParamCentered<LargePaleHoleKnob>(mm2px(Vec(108.017,  99.212)), module, Bezosc::PBEZ_PARAM + 11));
+    addParam(createHandleKnob(mm2px(Vec(108.017,  85.163)), module, 10));
+    addParam(createHandleKnob(mm2px(Vec(108.017,  99.212)), module, 11));
 
-    addParam(createParamCentered<LargePaleHoleKnob>(mm2px(Vec( 95.847, 112.443)), module, Bezosc::PBEZ_PARAM + 13)); //note swapped order!!
-    addParam(createParamCentered<LargePaleHoleKnob>(mm2px(Vec( 81.810, 112.443)), module, Bezosc::PBEZ_PARAM + 12));
+    addParam(createHandleKnob(mm2px(Vec( 95.847, 112.443)), module, 13)); //note swapped order!!
+    addParam(createHandleKnob(mm2px(Vec( 81.810, 112.443)), module, 12));
     addParam(createParamCentered<LargeCyanHoleKnob>(mm2px(Vec( 67.907, 112.443)), module, Bezosc::PBEZ_PARAM + 15));
     addParam(createParamCentered<LargeCyanHoleKnob>(mm2px(Vec( 53.726, 112.443)), module, Bezosc::PBEZ_PARAM + 14));
-    addParam(createParamCentered<LargePaleHoleKnob>(mm2px(Vec( 39.983, 112.443)), module, Bezosc::PBEZ_PARAM + 17));
-    addParam(createParamCentered<LargePaleHoleKnob>(mm2px(Vec( 25.934, 112.443)), module, Bezosc::PBEZ_PARAM + 16));
+    addParam(createHandleKnob(mm2px(Vec( 39.983, 112.443)), module, 17));
+    addParam(createHandleKnob(mm2px(Vec( 25.934, 112.443)), module, 16));
 
-		addParam(createParamCentered<LargePaleHoleKnob>(mm2px(Vec( 13.764,  99.212)), module, Bezosc::PBEZ_PARAM + 19)); //note swapped order!!
-    addParam(createParamCentered<LargePaleHoleKnob>(mm2px(Vec( 13.764,  85.163)), module, Bezosc::PBEZ_PARAM + 18));
+		addParam(createHandleKnob(mm2px(Vec( 13.764,  99.212)), module, 19)); //note swapped order!!
+    addParam(createHandleKnob(mm2px(Vec( 13.764,  85.163)), module, 18));
     addParam(createParamCentered<LargeCyanHoleKnob>(mm2px(Vec( 13.764,  71.420)), module, Bezosc::PBEZ_PARAM + 21));
     addParam(createParamCentered<LargeCyanHoleKnob>(mm2px(Vec( 13.764,  57.239)), module, Bezosc::PBEZ_PARAM + 20));
-    addParam(createParamCentered<LargePaleHoleKnob>(mm2px(Vec( 13.764,  43.336)), module, Bezosc::PBEZ_PARAM + 23));
-    addParam(createParamCentered<LargePaleHoleKnob>(mm2px(Vec( 13.764,  29.299)), module, Bezosc::PBEZ_PARAM + 22));
+    addParam(createHandleKnob(mm2px(Vec( 13.764,  43.336)), module, 23));
+    addParam(createHandleKnob(mm2px(Vec( 13.764,  29.299)), module, 22));
 
     addParam(createParamCentered<CyanHoleKnob>(mm2px(Vec(126.998, 16.068)), module, Bezosc::PBEZSCALEX_PARAM));
     addParam(createParamCentered<CyanHoleKnob>(mm2px(Vec(126.998, 25.697)), module, Bezosc::PBEZSCALEY_PARAM));
@@ -344,6 +1305,10 @@ struct BezoscWidget : ModuleWidget {
 
     addInput(createInputCentered<PJ301MSPort>(mm2px(Vec(131.853, 110.896)), module, Bezosc::IBEZFREQ_INPUT));
 
+    // Shape bus, in the free corners of the knob ring.
+    addInput(createInputCentered<PJ301MSPort>(mm2px(Vec( 13.764,  16.068)), module, Bezosc::BUSA_INPUT));
+    addInput(createInputCentered<PJ301MSPort>(mm2px(Vec(108.017,  16.068)), module, Bezosc::BUSB_INPUT));
+
 		addOutput(createOutputCentered<PJ301MDPort>(mm2px(Vec(137.158, 16.068)), module, Bezosc::OBEZX_OUTPUT));
 		addOutput(createOutputCentered<PJ301MDPort>(mm2px(Vec(137.158, 25.697)), module, Bezosc::OBEZY_OUTPUT));
 		addOutput(createOutputCentered<PJ301MDPort>(mm2px(Vec(137.158, 35.335)), module, Bezosc::OBEZTH_OUTPUT));
@@ -384,7 +1349,94 @@ struct BezoscWidget : ModuleWidget {
     addChild(createLightCentered<TinyLight<BlueLight>>(mm2px(Vec(  5.078,  50.209)), module, Bezosc::LLED_LIGHT + 25));
     addChild(createLightCentered<TinyLight<GreenLight>>(mm2px(Vec(  5.078,  43.336)), module, Bezosc::LLED_LIGHT + 26));
     addChild(createLightCentered<TinyLight<GreenLight>>(mm2px(Vec(  5.078,  29.299)), module, Bezosc::LLED_LIGHT + 27));
+
+    addChild(new BezoscDisplay(module, mm2px(Vec(25.934, 29.299)), mm2px(Vec(69.913, 69.913))));
 	}
+
+  struct OversampleItem : MenuItem {
+    Bezosc* module;
+    int oversample;
+    void onAction(const event::Action& e) override {
+      module->oversample = oversample;
+    }
+  };
+
+  struct BakedItem : MenuItem {
+    Bezosc* module;
+    void onAction(const event::Action& e) override {
+      module->setBaked(!module->baked);
+    }
+  };
+
+  struct PrecisionItem : MenuItem {
+    Bezosc* module;
+    bool fast;
+    void onAction(const event::Action& e) override {
+      module->fast = fast;
+    }
+  };
+
+  struct TraversalItem : MenuItem {
+    Bezosc* module;
+    bool arcLength;
+    void onAction(const event::Action& e) override {
+      module->arcLength = arcLength;
+    }
+  };
+
+  struct FollowItem : MenuItem {
+    Bezosc* module;
+    void onAction(const event::Action& e) override {
+      module->followLeft ^= true;
+    }
+  };
+
+  void appendContextMenu(Menu* menu) override {
+    Bezosc* module = dynamic_cast<Bezosc*>(this->module);
+
+    menu->addChild(new MenuSeparator);
+    menu->addChild(createMenuLabel("Oversampling"));
+    const int factors[] = {1, 2, 4, 8};
+    for (int factor : factors){
+      OversampleItem* item = createMenuItem<OversampleItem>(
+        std::to_string(factor) + "x", CHECKMARK(module->oversample == factor)
+      );
+      item->module = module;
+      item->oversample = factor;
+      menu->addChild(item);
+    }
+
+    menu->addChild(new MenuSeparator);
+    menu->addChild(createMenuLabel("Traversal"));
+    const char* traversals[] = {"Uniform per segment", "Constant speed"};
+    for (int i = 0; i < 2; i++){
+      TraversalItem* item = createMenuItem<TraversalItem>(traversals[i], CHECKMARK(module->arcLength == (i == 1)));
+      item->module = module;
+      item->arcLength = (i == 1);
+      menu->addChild(item);
+    }
+
+    menu->addChild(new MenuSeparator);
+    menu->addChild(createMenuLabel("Theta and length"));
+    const char* precisions[] = {"Exact", "Fast"};
+    for (int i = 0; i < 2; i++){
+      PrecisionItem* item = createMenuItem<PrecisionItem>(precisions[i], CHECKMARK(module->fast == (i == 1)));
+      item->module = module;
+      item->fast = (i == 1);
+      menu->addChild(item);
+    }
+
+    menu->addChild(new MenuSeparator);
+    BakedItem* bakedItem = createMenuItem<BakedItem>("Baked wavetable", CHECKMARK(module->baked));
+    bakedItem->module = module;
+    menu->addChild(bakedItem);
+
+    FollowItem* followItem = createMenuItem<FollowItem>("Spline from the module on the left", CHECKMARK(module->followLeft));
+    followItem->module = module;
+    menu->addChild(followItem);
+
+    appendUiRateMenu(menu, &module->uiClock);
+  }
 };
 
 Model* modelBezosc = createModel<Bezosc, BezoscWidget>("Bezosc");
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "plugin.hpp"
 #include "rampcomponent.hpp"
+#include "uisync.hpp"
+#include "bezier.hpp"
 #include <cmath>
 using simd::float_4;
 
@@ -9,11 +11,17 @@ struct Ramp : Module {
 		ENUMS(VTO_PARAM, 8),
 		ENUMS(TIME_PARAM, 8),
 		ENUMS(INTERP_PARAM, 8),
+		ENUMS(HANDLE1_PARAM, 8),
+		ENUMS(HANDLE2_PARAM, 8),
 		NUM_PARAMS
 	};
 	enum InputIds {
 		ENUMS(START_INPUT, 8),
 		ENUMS(STOP_INPUT, 8),
+		FROM_CV_INPUT,
+		TO_CV_INPUT,
+		TIME_CV_INPUT,
+		INTERP_CV_INPUT,
 		NUM_INPUTS
 	};
 	enum OutputIds {
@@ -28,19 +36,203 @@ struct Ramp : Module {
 		NUM_LIGHTS
 	};
 
-	float gc[8];
-	bool running[8];
-	bool finished[8];
-	bool stopped[8];
-	bool endPulse[8];
-	dsp::SchmittTrigger startTrigger[8];
-	dsp::SchmittTrigger stopTrigger[8];
-	dsp::PulseGenerator endPulseGen[8];
-
-	/** Interpolates over gs, ge and rescales to ts, te.
-	gc: global current
-	//gs: global start omitted as gs is always 0
-	ge: global end
+	// Every active row runs one ramp per channel of its start input. The
+	// ramps are packed in row order into groups of four, 8 mono rows take
+	// two groups, 8 rows of 16 channels 32. State flags are lane masks.
+	static const int maxChannels = 16;
+	static const int maxRamps = 8 * maxChannels;
+	static const int maxGroups = maxRamps / 4;
+	// Channels and first ramp of every row, 0 channels for an inactive row.
+	int rowChannels[8] = {};
+	int rowStart[8] = {};
+	int numRamps = 0;
+	int numGroups = 0;
+	int rampRow[maxRamps] = {};
+	int rampChannel[maxRamps] = {};
+	// Row of a group with all four lanes on one row, its ports are read and
+	// written as vectors. -1 for a group spanning rows or partly empty.
+	int groupRow[maxGroups] = {};
+	// Channels of the lanes of a group, maxChannels past the last ramp.
+	float_4 groupChannels[maxGroups];
+	// Port voltages of the ramps of the groups spanning rows, read and
+	// written lane by lane. Lanes past the last ramp read 0 V from
+	// spareIn and write to spareOut.
+	float* startPort[maxRamps];
+	float* stopPort[maxRamps];
+	float* endPort[maxRamps];
+	float* outBPort[maxRamps];
+	float* outUPort[maxRamps];
+	float spareIn = 0.f;
+	float spareOut[3];
+
+	// Ramps run on a 64-bit sample count. A ramp started on frame s, its
+	// edge startOffset samples before, has run f - s + startOffset samples
+	// on frame f and ends on endFrame, the first frame at or past its time,
+	// exact over the full 1200 s. groupEnd is the first end frame of the
+	// running lanes of a group, the lanes are only compared when it is
+	// reached.
+	int64_t frame = 0;
+	int64_t startFrame[maxRamps] = {};
+	int64_t endFrame[maxRamps] = {};
+	// Offsets in [0, 1] from the crossing of the trigger threshold between
+	// the last two input samples, only computed on an edge.
+	float startOffset[maxRamps] = {};
+	float_4 lastStart[maxGroups];
+	int64_t groupEnd[maxGroups];
+	// Bit g set for a group with running ramps or an end pulse. Other
+	// groups only watch their start and stop inputs, the outputs keep their
+	// voltages. Their knobs are not gathered, stale, until an edge wakes
+	// them. The param pass and the CVs only look at the To their finished
+	// or holding lanes rest on and at the layout, refresh wakes them for a
+	// change.
+	uint32_t busy = 0;
+	uint32_t stale = 0;
+	uint32_t refresh = 0;
+	float_4 running[maxGroups];
+	float_4 finished[maxGroups];
+	float_4 endPulse[maxGroups];
+	// The end light stays on over a retrigger, until the ramp is stopped.
+	float_4 endLight[maxGroups];
+	dsp::TSchmittTrigger<float_4> startTrigger[maxGroups];
+	dsp::TSchmittTrigger<float_4> stopTrigger[maxGroups];
+	// Remaining time of the end pulse, like dsp::PulseGenerator.
+	float_4 endPulseTime[maxGroups];
+	// Knobs and connections, read every paramDivision samples. The CV
+	// overrides are followed on every sample, a CV is gathered again when
+	// its channels or voltages differ from the last sample, kept for
+	// FROM_CV_INPUT + k in cvChannels[k] and cvLast[k], 0 channels while
+	// unpatched.
+	static const int paramDivision = 16;
+	dsp::ClockDivider paramDivider;
+	int cvChannels[4] = {};
+	float cvLast[4][maxChannels] = {};
+	float_4 active[maxGroups];
+	float_4 hasStop[maxGroups];
+	float_4 from[maxGroups];
+	float_4 to[maxGroups];
+	float_4 time[maxGroups];
+	float_4 interp[maxGroups];
+	// Last voltages written, outputs not touched in a sample keep them.
+	float_4 outU[maxGroups];
+	float_4 outB[maxGroups];
+	float_4 outEnd[maxGroups];
+	// Chain mode, the rows are the stages of one breakpoint envelope per
+	// channel of the start input of row 1. A stage starts from the voltage
+	// the last one left on the same sample. The mode switches in process(),
+	// requested from the menu. -1 for no sustain or loop stage.
+	bool chain = false;
+	bool chainRequested = false;
+	int sustainStage = -1;
+	int loopStage = -1;
+	int stage[maxRamps] = {};
+	// Lanes waiting at the end of the sustain stage for the gate to fall.
+	float_4 holding[maxGroups];
+	// End pulses of the stages, per row, bit 4 * row + g set while one runs.
+	float_4 stagePulseTime[8][maxChannels / 4];
+	uint32_t stagePulses = 0;
+	// Lights follow the ramp state, staged and written at the UI rate.
+	UiClock uiClock;
+	UiValues<NUM_LIGHTS> uiLights;
+
+	// Incremental curves, reseeded from the exact values on start and every
+	// paramDivision samples, a few adds and multiplies per sample in between.
+	// pos = elapsed time / time, the reciprocal of the time is cached.
+	float_4 invTime[maxGroups];
+	float_4 pos[maxGroups];
+	float_4 posStep[maxGroups];
+	// cos(pi pos), sin(pi pos), rotated by pi posStep every sample.
+	float_4 cosPos[maxGroups];
+	float_4 sinPos[maxGroups];
+	float_4 cosStep[maxGroups];
+	float_4 sinStep[maxGroups];
+	float_4 rotationStep[maxGroups];
+	// pos^im as a cubic Hermite over the block, in forward differences.
+	// Lanes still in the first block after the start are evaluated directly,
+	// the slope of pos^im is unbounded at 0 for im < 1.
+	float_4 powY[maxGroups];
+	float_4 powD1[maxGroups];
+	float_4 powD2[maxGroups];
+	float_4 powD3[maxGroups];
+	float_4 powDirect[maxGroups];
+	// Lanes of group g on the cosine, step and power curves, set on a
+	// reseed.
+	int cosLanes[maxGroups] = {};
+	int stepLanes[maxGroups] = {};
+	int powLanes[maxGroups] = {};
+	// Bezier curves, B(pos) through 0, handle 1, handle 2, 1 per row, set
+	// from the menu. The power basis coefficients are rebuilt when a handle
+	// moves and gathered per lane with the knobs, a Bezier lane runs the
+	// linear curve state and adds a Horner step.
+	bool bezierRow[8] = {};
+	bool anyBezier = false;
+	float rowHandles[8][2];
+	float rowCurve[8][4];
+	float_4 bezier[maxGroups];
+	float_4 curve[maxGroups][4];
+
+	/** Exact curve state of group g on this frame. Costs a cos, a sin and
+	    two pow per lane, once per block.
+	*/
+	void reseedCurves(int g, float sampleTime) {
+		float_4 im = interp[g];
+		invTime[g] = 1.f / time[g];
+		float_4 elapsed = lanes([&](int l) {
+			int i = 4 * g + l;
+			return (float) ((frame - startFrame[i] + (double) startOffset[i]) * sampleTime);
+		});
+		pos[g] = elapsed * invTime[g];
+		posStep[g] = sampleTime * invTime[g];
+		cosLanes[g] = simd::movemask(im == 0.f);
+		stepLanes[g] = simd::movemask(im == 10.f);
+		powLanes[g] = simd::movemask((im != 0.f) & (im != 1.f) & (im != 10.f));
+		if (cosLanes[g]) {
+			cosPos[g] = simd::cos(pos[g] * float(M_PI));
+			sinPos[g] = simd::sin(pos[g] * float(M_PI));
+			// The rotation only changes with the time knob or the sample rate.
+			if (simd::movemask(posStep[g] != rotationStep[g])) {
+				rotationStep[g] = posStep[g];
+				cosStep[g] = simd::cos(posStep[g] * float(M_PI));
+				sinStep[g] = simd::sin(posStep[g] * float(M_PI));
+			}
+		}
+		if (powLanes[g]) {
+			const float h = 1.f / paramDivision;
+			float_4 span = posStep[g] * float(paramDivision);
+			float_4 x0 = pos[g];
+			float_4 x1 = x0 + span;
+			float_4 y0 = simd::pow(x0, im);
+			float_4 y1 = simd::pow(x1, im);
+			// Slopes per block, d/dx x^im = im x^im / x. A ramp started
+			// right on its edge is at x0 = 0, evaluated directly.
+			float_4 m0 = simd::ifelse(x0 > 0.f, im * y0 / x0, 0.f) * span;
+			float_4 m1 = im * y1 / x1 * span;
+			float_4 c2 = 3.f * (y1 - y0) - 2.f * m0 - m1;
+			float_4 c3 = 2.f * (y0 - y1) + m0 + m1;
+			powY[g] = y0;
+			powD1[g] = (m0 + (c2 + c3 * h) * h) * h;
+			powD2[g] = (2.f * c2 + 6.f * c3 * h) * h * h;
+			powD3[g] = 6.f * c3 * h * h * h;
+			powDirect[g] = x0 < span;
+		}
+	}
+
+	/** Moves the curve state of group g one sample on. */
+	void advanceCurves(int g) {
+		pos[g] += posStep[g];
+		if (cosLanes[g]) {
+			float_4 c = cosPos[g];
+			cosPos[g] = c * cosStep[g] - sinPos[g] * sinStep[g];
+			sinPos[g] = sinPos[g] * cosStep[g] + c * sinStep[g];
+		}
+		if (powLanes[g]) {
+			powY[g] += powD1[g];
+			powD1[g] += powD2[g];
+			powD2[g] += powD3[g];
+		}
+	}
+
+	/** Interpolates from ts to te over the ramp, four channels, from the
+	curve state of group g.
 	ts: target start
 	te: target end
 	im: interpolation method,
@@ -49,17 +241,31 @@ struct Ramp : Module {
 	    im = 1     - linear
 	    1> im <10  - exponential (ease out)
 	    im = 10    - step
+	The methods are selected per lane, a lane on a Bezier row has im = 1
+	and follows its curve instead.
 	*/
-	inline float interpolate(float gc, float ge, float ts, float te, float im) {
-	  float v;
-		if (im == 0.f) {                             				// cosine
-	      float f = (1 - simd::cos((gc / ge) * M_PI)) * 0.5;
-	      v = ts * (1 - f) + te * f;
-	  }
-	  else if (im == 1.f) {v = ts + (te - ts) * (gc / ge);}
-	  else if (im == 10.f) {(gc == ge) ? v = te : v = ts;}  // step
-	  else {v = ts + (te - ts) * simd::pow((gc / ge), im);}
-	  return v;
+	inline float_4 interpolate(int g, float_4 ts, float_4 te, float_4 im) {
+		float_4 v = ts + (te - ts) * pos[g];                  // linear
+		if (cosLanes[g]) {                                    // cosine
+			float_4 f = (1.f - cosPos[g]) * 0.5f;
+			v = simd::ifelse(im == 0.f, ts * (1.f - f) + te * f, v);
+		}
+		if (stepLanes[g]) {                                   // step, te at the end
+			v = simd::ifelse(im == 10.f, ts, v);
+		}
+		if (powLanes[g]) {
+			float_4 isPow = (im != 0.f) & (im != 1.f) & (im != 10.f);
+			float_4 y = powY[g];
+			if (simd::movemask(isPow & powDirect[g])) {
+				y = simd::ifelse(powDirect[g], simd::pow(pos[g], im), y);
+			}
+			v = simd::ifelse(isPow, ts + (te - ts) * y, v);
+		}
+		float_4 isBezier = bezier[g];
+		if (simd::movemask(isBezier)) {                       // Bezier
+			v = simd::ifelse(isBezier, ts + (te - ts) * bezierHorner(curve[g], pos[g]), v);
+		}
+		return v;
 	}
 
 
@@ -70,84 +276,936 @@ struct Ramp : Module {
 			configParam(VTO_PARAM + i, 0.f, 10.f, 0.f, "Voltage to");
 			configParam(TIME_PARAM + i, 0.f, 1200.f, 0.f, "time", "s");
 			configParam(INTERP_PARAM + i, 0.f, 10.f, 0.f, "interpolate");
-			gc[i] = 0;
-			running[i] = false;
-			finished[i] = false;
-			stopped[i] = true;
-			endPulse[i] = false;
+			// Not on the panel, set from the context menu. The defaults
+			// make the Bezier curve linear.
+			configParam(HANDLE1_PARAM + i, -1.f, 2.f, 1.f / 3.f, "Bezier handle 1");
+			configParam(HANDLE2_PARAM + i, -1.f, 2.f, 2.f / 3.f, "Bezier handle 2");
+			// Out of range, the curves are built on the first read.
+			rowHandles[i][0] = rowHandles[i][1] = -10.f;
 		}
+		for (int g = 0; g < maxGroups; g++) {
+			groupEnd[g] = INT64_MAX;
+			running[g] = 0.f;
+			finished[g] = 0.f;
+			endPulse[g] = 0.f;
+			endLight[g] = 0.f;
+			holding[g] = 0.f;
+			endPulseTime[g] = 0.f;
+			lastStart[g] = 0.f;
+			groupChannels[g] = float(maxChannels);
+			active[g] = 0.f;
+			hasStop[g] = 0.f;
+			from[g] = 0.f;
+			to[g] = 0.f;
+			time[g] = 0.f;
+			interp[g] = 0.f;
+			outU[g] = 0.f;
+			outB[g] = 0.f;
+			outEnd[g] = 0.f;
+			invTime[g] = 0.f;
+			pos[g] = 0.f;
+			posStep[g] = 0.f;
+			cosPos[g] = 1.f;
+			sinPos[g] = 0.f;
+			cosStep[g] = 1.f;
+			sinStep[g] = 0.f;
+			rotationStep[g] = 0.f;
+			powY[g] = 0.f;
+			powD1[g] = 0.f;
+			powD2[g] = 0.f;
+			powD3[g] = 0.f;
+			powDirect[g] = 0.f;
+			bezier[g] = 0.f;
+			for (int j = 0; j < 4; j++) {
+				curve[g][j] = 0.f;
+			}
+		}
+		for (int r = 0; r < 8; r++) {
+			for (int g = 0; g < maxChannels / 4; g++) {
+				stagePulseTime[r][g] = 0.f;
+			}
+		}
+		paramDivider.setDivision(paramDivision);
 		onReset();
 	}
 
-	void process(const ProcessArgs& args) override {
-		for (int i = 0; i < 8; i++) {
-			if (
-				inputs[START_INPUT + i].isConnected() 
+	/** Four lanes from f(0) .. f(3), built in registers. */
+	template <typename F>
+	static float_4 lanes(F f) {
+		return float_4(f(0), f(1), f(2), f(3));
+	}
+
+	/** Samples since the input crossed the 1 V threshold of a rising edge,
+	    between last and in, linearly interpolated.
+	*/
+	static float_4 risingOffset(float_4 last, float_4 in) {
+		return simd::clamp((in - 1.f) / simd::fmax(in - last, 1e-6f), 0.f, 1.f);
+	}
+
+	/** Samples since the input crossed 0 V on a falling edge. */
+	static float_4 fallingOffset(float_4 last, float_4 in) {
+		return simd::clamp(-in / simd::fmax(last - in, 1e-6f), 0.f, 1.f);
+	}
+
+	/** Schmitt trigger of the lanes in mask, the others keep their state. */
+	static float_4 trigger(dsp::TSchmittTrigger<float_4>& t, float_4 in, float_4 mask) {
+		float_4 state = t.state;
+		float_4 triggered = t.process(in) & mask;
+		t.state = simd::ifelse(mask, t.state, state);
+		return triggered;
+	}
+
+	/** Moves the lanes of one state array, ramp i takes the state of old
+	    ramp from[i], or init for -1.
+	*/
+	template <typename F>
+	static void moveLanes(const int* from, F lane, float init) {
+		float old[maxRamps];
+		for (int g = 0; g < maxGroups; g++) {
+			lane(g).store(&old[4 * g]);
+		}
+		for (int g = 0; g < maxGroups; g++) {
+			lane(g) = lanes([&](int l) {
+				int f = from[4 * g + l];
+				return (f >= 0) ? old[f] : init;
+			});
+		}
+	}
+
+	/** Moves every ramp to its new place after the channel count of a row
+	    changed, ramps of channels the row did not have before start idle.
+	*/
+	void moveRamps(const int* oldStart, const int* oldChannels) {
+		int from[maxRamps];
+		for (int i = 0; i < maxRamps; i++) {
+			from[i] = -1;
+			if (i < numRamps && rampChannel[i] < oldChannels[rampRow[i]]) {
+				from[i] = oldStart[rampRow[i]] + rampChannel[i];
+			}
+		}
+		float high = float_4::mask()[0];
+		int64_t start[maxRamps];
+		int64_t end[maxRamps];
+		float offset[maxRamps];
+		std::copy(startFrame, startFrame + maxRamps, start);
+		std::copy(endFrame, endFrame + maxRamps, end);
+		std::copy(startOffset, startOffset + maxRamps, offset);
+		int oldStage[maxRamps];
+		std::copy(stage, stage + maxRamps, oldStage);
+		for (int i = 0; i < maxRamps; i++) {
+			startFrame[i] = (from[i] >= 0) ? start[from[i]] : 0;
+			endFrame[i] = (from[i] >= 0) ? end[from[i]] : 0;
+			startOffset[i] = (from[i] >= 0) ? offset[from[i]] : 0.f;
+			stage[i] = (from[i] >= 0) ? oldStage[from[i]] : 0;
+		}
+		moveLanes(from, [&](int g) -> float_4& {return running[g];}, 0.f);
+		moveLanes(from, [&](int g) -> float_4& {return finished[g];}, 0.f);
+		moveLanes(from, [&](int g) -> float_4& {return endPulse[g];}, 0.f);
+		moveLanes(from, [&](int g) -> float_4& {return endLight[g];}, 0.f);
+		moveLanes(from, [&](int g) -> float_4& {return holding[g];}, 0.f);
+		moveLanes(from, [&](int g) -> float_4& {return endPulseTime[g];}, 0.f);
+		moveLanes(from, [&](int g) -> float_4& {return outU[g];}, 0.f);
+		moveLanes(from, [&](int g) -> float_4& {return outB[g];}, 0.f);
+		moveLanes(from, [&](int g) -> float_4& {return outEnd[g];}, 0.f);
+		moveLanes(from, [&](int g) -> float_4& {return lastStart[g];}, 0.f);
+		moveLanes(from, [&](int g) -> float_4& {return time[g];}, 0.f);
+		moveLanes(from, [&](int g) -> float_4& {return startTrigger[g].state;}, high);
+		moveLanes(from, [&](int g) -> float_4& {return stopTrigger[g].state;}, high);
+		// The curves are reseeded on this sample, the rotation is recomputed.
+		for (int g = 0; g < maxGroups; g++) {
+			rotationStep[g] = -1.f;
+		}
+	}
+
+	/** Packs the ramps of the active rows, a row is active with its start
+	    input and an output connected and runs one ramp per start channel.
+	    In chain mode row 1 runs one envelope per start channel, its Vuni
+	    and Vbi carry them, the END outputs of all rows the stage ends.
+	*/
+	void layoutRamps() {
+		int oldStart[8];
+		int oldChannels[8];
+		bool changed = false;
+		numRamps = 0;
+		for (int r = 0; r < 8; r++) {
+			bool active = chain ? (r == 0 && inputs[START_INPUT].isConnected()) : (
+				inputs[START_INPUT + r].isConnected()
 				&& (
-					outputs[END_OUTPUT + i].isConnected()
-					|| outputs[VOUTU_OUTPUT + i].isConnected() 
-					|| outputs[VOUTB_OUTPUT + i].isConnected()
-				) == true
-			) {
-				if (startTrigger[i].process(inputs[START_INPUT + i].getVoltage()) == true) {
-					gc[i] = 0;
-					running[i] = true;
-					finished[i] = false;
-					stopped[i] = false;
+					outputs[END_OUTPUT + r].isConnected()
+					|| outputs[VOUTU_OUTPUT + r].isConnected()
+					|| outputs[VOUTB_OUTPUT + r].isConnected()
+				)
+			);
+			int channels = active ? inputs[START_INPUT + r].getChannels() : 0;
+			oldStart[r] = rowStart[r];
+			oldChannels[r] = rowChannels[r];
+			rowStart[r] = numRamps;
+			rowChannels[r] = channels;
+			changed |= (rowStart[r] != oldStart[r] || channels != oldChannels[r]);
+			for (int ch = 0; ch < channels; ch++) {
+				rampRow[numRamps] = r;
+				rampChannel[numRamps] = ch;
+				numRamps++;
+			}
+			int outChannels = std::max(chain ? rowChannels[0] : channels, 1);
+			outputs[END_OUTPUT + r].setChannels(outChannels);
+			outputs[VOUTB_OUTPUT + r].setChannels(outChannels);
+			outputs[VOUTU_OUTPUT + r].setChannels(outChannels);
+			if (!active) {
+				if (!chain) {
+					outputs[END_OUTPUT + r].setVoltage(0.f);
+				}
+				outputs[VOUTB_OUTPUT + r].setVoltage(0.f);
+				outputs[VOUTU_OUTPUT + r].setVoltage(0.f);
+			}
+		}
+		numGroups = (numRamps + 3) / 4;
+		if (!changed) {
+			return;
+		}
+		refresh = ~0u;
+		for (int g = 0; g < maxGroups; g++) {
+			int i = 4 * g;
+			bool oneRow = i + 3 < numRamps && rampRow[i] == rampRow[i + 3];
+			groupRow[g] = oneRow ? rampRow[i] : -1;
+			groupChannels[g] = lanes([&](int l) {return (i + l < numRamps) ? (float) rampChannel[i + l] : (float) maxChannels;});
+		}
+		moveRamps(oldStart, oldChannels);
+	}
+
+	/** Row whose knobs ramp i follows, the row of its stage in chain mode. */
+	int knobRow(int i) {
+		return chain ? stage[i] : rampRow[i];
+	}
+
+	/** Knob of the row of ramp i, overridden by the CV in the knob's units
+	    when the CV has the ramp's channel.
+	*/
+	float knob(int cvId, int paramId, int i, float max) {
+		int ch = rampChannel[i];
+		if (ch < inputs[cvId].getChannels()) {
+			return clamp(inputs[cvId].getVoltage(ch), 0.f, max);
+		}
+		return params[paramId + knobRow(i)].getValue();
+	}
+
+	/** Time of ramp i in seconds. The CV covers the knob's range, 0 to 10 V
+	    exponentially onto 0 to 1200 s, 2^V - 1 scaled, 1 V is about 1.2 s,
+	    5 V 36 s, so short ramps keep their resolution.
+	*/
+	float timeKnob(int i) {
+		int ch = rampChannel[i];
+		if (ch < inputs[TIME_CV_INPUT].getChannels()) {
+			float v = clamp(inputs[TIME_CV_INPUT].getVoltage(ch), 0.f, 10.f);
+			return 1200.f * (std::exp2(v) - 1.f) / 1023.f;
+		}
+		return params[TIME_PARAM + knobRow(i)].getValue();
+	}
+
+	/** Interpolation of ramp i, linear on a Bezier row. */
+	float interpKnob(int i) {
+		return bezierRow[knobRow(i)] ? 1.f : knob(INTERP_CV_INPUT, INTERP_PARAM, i, 10.f);
+	}
+
+	/** Rebuilds the coefficients of the rows whose handles moved. */
+	void updateCurves() {
+		anyBezier = false;
+		for (int r = 0; r < 8; r++) {
+			anyBezier |= bezierRow[r];
+			float h1 = params[HANDLE1_PARAM + r].getValue();
+			float h2 = params[HANDLE2_PARAM + r].getValue();
+			if (h1 == rowHandles[r][0] && h2 == rowHandles[r][1]) {
+				continue;
+			}
+			rowHandles[r][0] = h1;
+			rowHandles[r][1] = h2;
+			const float P[4] = {0.f, h1, h2, 1.f};
+			bezierCoefs(P, rowCurve[r]);
+		}
+	}
+
+	/** Bezier mask and coefficients of the lanes of group g. */
+	void gatherCurves(int g) {
+		int c = 4 * g;
+		if (!anyBezier) {
+			bezier[g] = float_4::zero();
+			return;
+		}
+		bezier[g] = lanes([&](int l) {return (c + l < numRamps && bezierRow[knobRow(c + l)]) ? 1.f : 0.f;}) > 0.f;
+		for (int j = 0; j < 4; j++) {
+			curve[g][j] = lanes([&](int l) {return (c + l < numRamps) ? rowCurve[knobRow(c + l)][j] : 0.f;});
+		}
+	}
+
+	/** Frames from the start frame to the end frame of a ramp of the given
+	    time and start offset, it ends on the first frame at or past the
+	    time and runs for at least the start frame.
+	*/
+	static int64_t rampFrames(float time, float offset, float sampleRate) {
+		return std::max<int64_t>(0, (int64_t) std::ceil((double) time * sampleRate - offset));
+	}
+
+	/** Samples ramp i has run past its time on its end frame, in [0, 1). */
+	float endExcess(int i, float time, float sampleRate) {
+		double excess = endFrame[i] - startFrame[i] + (double) startOffset[i] - (double) time * sampleRate;
+		return clamp((float) excess, 0.f, 1.f);
+	}
+
+	/** Sets the end frames of the lanes in mask from their time and the
+	    first end frame of the running lanes of group g.
+	*/
+	void schedule(int g, int mask, float sampleRate) {
+		int isRunning = simd::movemask(running[g] & active[g]);
+		groupEnd[g] = INT64_MAX;
+		for (int l = 0; l < 4; l++) {
+			int i = 4 * g + l;
+			if ((mask >> l) & 1) {
+				endFrame[i] = startFrame[i] + rampFrames(time[g][l], startOffset[i], sampleRate);
+			}
+			if ((isRunning >> l) & 1) {
+				groupEnd[g] = std::min(groupEnd[g], endFrame[i]);
+			}
+		}
+	}
+
+	/** knob() of the lanes of group g, 0 past the last ramp. The CV is
+	    loaded and clamped as a vector, a vector load for a group on one
+	    row.
+	*/
+	float_4 gatherKnob(int cvId, int paramId, int g, float max) {
+		int c = 4 * g;
+		int row = chain ? -1 : groupRow[g];
+		float_4 v = (row >= 0)
+			? float_4(params[paramId + row].getValue())
+			: lanes([&](int l) {return (c + l < numRamps) ? params[paramId + knobRow(c + l)].getValue() : 0.f;});
+		Input& cv = inputs[cvId];
+		int channels = cv.getChannels();
+		if (channels == 0) {
+			return v;
+		}
+		float_4 in = (groupRow[g] >= 0)
+			? cv.getVoltageSimd<float_4>(rampChannel[c])
+			: lanes([&](int l) {return cv.getVoltage(rampChannel[c + l]);});
+		return simd::ifelse(groupChannels[g] < float(channels), simd::clamp(in, 0.f, max), v);
+	}
+
+	/** From knob of the lanes of group g. */
+	float_4 gatherFrom(int g) {
+		return gatherKnob(FROM_CV_INPUT, VFROM_PARAM, g, 10.f);
+	}
+
+	/** To knob of the lanes of group g. */
+	float_4 gatherTo(int g) {
+		return gatherKnob(TO_CV_INPUT, VTO_PARAM, g, 10.f);
+	}
+
+	/** Time of the lanes of group g, the running ones are rescheduled when
+	    it moved.
+	*/
+	void gatherTime(int g, float sampleRate) {
+		int c = 4 * g;
+		float_4 oldTime = time[g];
+		time[g] = lanes([&](int l) {return (c + l < numRamps) ? timeKnob(c + l) : 0.f;});
+		schedule(g, simd::movemask((time[g] != oldTime) & running[g] & active[g]), sampleRate);
+	}
+
+	/** Interpolation of the lanes of group g, like interpKnob(). */
+	float_4 gatherInterp(int g) {
+		int c = 4 * g;
+		float_4 v = gatherKnob(INTERP_CV_INPUT, INTERP_PARAM, g, 10.f);
+		if (!anyBezier) {
+			return v;
+		}
+		float_4 isBezier = lanes([&](int l) {return (c + l < numRamps && bezierRow[knobRow(c + l)]) ? 1.f : 0.f;}) > 0.f;
+		return simd::ifelse(isBezier, 1.f, v);
+	}
+
+	/** Gathers the knobs and CV overrides of group g per lane, its running
+	    ramps follow a change of their time.
+	*/
+	void gatherKnobs(int g, float sampleRate) {
+		// A stage starts from the voltage the last one left.
+		if (!chain) {
+			from[g] = gatherFrom(g);
+		}
+		to[g] = gatherTo(g);
+		gatherTime(g, sampleRate);
+		interp[g] = gatherInterp(g);
+		gatherCurves(g);
+		stale &= ~(1u << g);
+	}
+
+	/** Points the lanes of group g at the voltages of their ports. */
+	void mapPorts(int g) {
+		for (int i = 4 * g; i < 4 * g + 4; i++) {
+			if (i >= numRamps) {
+				startPort[i] = stopPort[i] = &spareIn;
+				endPort[i] = &spareOut[0];
+				outBPort[i] = &spareOut[1];
+				outUPort[i] = &spareOut[2];
+				continue;
+			}
+			int r = rampRow[i];
+			int ch = rampChannel[i];
+			Input& stop = inputs[STOP_INPUT + r];
+			startPort[i] = &inputs[START_INPUT + r].voltages[ch];
+			stopPort[i] = &stop.voltages[stop.isMonophonic() ? 0 : ch];
+			endPort[i] = &outputs[END_OUTPUT + r].voltages[ch];
+			outBPort[i] = &outputs[VOUTB_OUTPUT + r].voltages[ch];
+			outUPort[i] = &outputs[VOUTU_OUTPUT + r].voltages[ch];
+		}
+	}
+
+	/** Lays out the ramps and reads connections, gathers the knobs of the
+	    busy groups. An idle group only has its To knob checked.
+	*/
+	void readParams(float sampleRate) {
+		layoutRamps();
+		updateCurves();
+		for (int g = 0; g < numGroups; g++) {
+			int c = 4 * g;
+			active[g] = lanes([&](int l) {return (c + l < numRamps) ? 1.f : 0.f;}) > 0.f;
+			hasStop[g] = lanes([&](int l) {
+				return (c + l < numRamps && inputs[STOP_INPUT + rampRow[c + l]].isConnected()) ? 1.f : 0.f;
+			}) > 0.f;
+			if (groupRow[g] < 0) {
+				mapPorts(g);
+			}
+			if ((busy >> g) & 1) {
+				gatherKnobs(g, sampleRate);
+				continue;
+			}
+			stale |= 1u << g;
+			followTo(g);
+		}
+	}
+
+	/** Takes the To of idle group g, wakes it when the voltage its finished
+	    or holding lanes rest on moved.
+	*/
+	void followTo(int g) {
+		float_4 to = gatherTo(g);
+		if (simd::movemask((to != this->to[g]) & (finished[g] | holding[g]) & active[g])) {
+			refresh |= 1u << g;
+		}
+		this->to[g] = to;
+	}
+
+	/** Follows the CV overrides between the param passes, a jack plugged in
+	    or pulled is seen on the same sample. The busy groups take the CVs
+	    that moved, an idle group is only woken for a change of its To.
+	    Returns the groups whose time or interpolation moved, their curves
+	    are reseeded.
+	*/
+	uint32_t readCv(float sampleRate) {
+		int cv = 0;
+		for (int k = 0; k < 4; k++) {
+			Input& in = inputs[FROM_CV_INPUT + k];
+			int channels = in.getChannels();
+			if (channels == cvChannels[k] && std::equal(in.voltages, in.voltages + channels, cvLast[k])) {
+				continue;
+			}
+			cv |= 1 << k;
+			cvChannels[k] = channels;
+			std::copy(in.voltages, in.voltages + channels, cvLast[k]);
+		}
+		if (!cv) {
+			return 0;
+		}
+		auto follows = [&](int id) {return (cv >> (id - FROM_CV_INPUT)) & 1;};
+		// An idle group gathers the rest on its next edge.
+		stale |= ~busy;
+		uint32_t moved = 0;
+		for (int g = 0; g < numGroups; g++) {
+			uint32_t bit = 1u << g;
+			if (!(busy & bit)) {
+				if (follows(TO_CV_INPUT)) {
+					followTo(g);
+				}
+				continue;
+			}
+			if (follows(FROM_CV_INPUT) && !chain) {
+				from[g] = gatherFrom(g);
+			}
+			if (follows(TO_CV_INPUT)) {
+				to[g] = gatherTo(g);
+			}
+			if (follows(TIME_CV_INPUT)) {
+				float_4 oldTime = time[g];
+				gatherTime(g, sampleRate);
+				moved |= simd::movemask((time[g] != oldTime) & running[g]) ? bit : 0;
+			}
+			if (follows(INTERP_CV_INPUT)) {
+				float_4 oldInterp = interp[g];
+				interp[g] = gatherInterp(g);
+				moved |= simd::movemask((interp[g] != oldInterp) & running[g]) ? bit : 0;
+			}
+		}
+		return moved;
+	}
+
+	/** True if group g has to be processed on this sample, its knobs are
+	    gathered first if they are stale.
+	*/
+	bool wake(int g, bool edge, float sampleRate) {
+		uint32_t bit = 1u << g;
+		if (!((busy | refresh) & bit) && !edge) {
+			return false;
+		}
+		refresh &= ~bit;
+		if (stale & bit) {
+			gatherKnobs(g, sampleRate);
+		}
+		return true;
+	}
+
+	/** Start and stop voltages of group g, vector loads for a group on one
+	    row. A mono stop input stops every channel of its row.
+	*/
+	void readInputs(int g, float_4& startIn, float_4& stopIn) {
+		int row = groupRow[g];
+		int c = 4 * g;
+		if (row >= 0) {
+			startIn = inputs[START_INPUT + row].getVoltageSimd<float_4>(rampChannel[c]);
+			stopIn = inputs[STOP_INPUT + row].getPolyVoltageSimd<float_4>(rampChannel[c]);
+			return;
+		}
+		startIn = lanes([&](int l) {return *startPort[c + l];});
+		stopIn = lanes([&](int l) {return *stopPort[c + l];});
+	}
+
+	/** Sets the outputs of group g, vector stores for a group on one row.
+	    The END outputs are left alone without end.
+	*/
+	void writeOutputs(int g, bool end) {
+		int row = groupRow[g];
+		int c = 4 * g;
+		if (row >= 0) {
+			outputs[VOUTU_OUTPUT + row].setVoltageSimd(outU[g], rampChannel[c]);
+			outputs[VOUTB_OUTPUT + row].setVoltageSimd(outB[g], rampChannel[c]);
+			if (end) {
+				outputs[END_OUTPUT + row].setVoltageSimd(outEnd[g], rampChannel[c]);
+			}
+			return;
+		}
+		for (int l = 0; l < 4; l++) {
+			*outUPort[c + l] = outU[g][l];
+			*outBPort[c + l] = outB[g][l];
+			if (end) {
+				*endPort[c + l] = outEnd[g][l];
+			}
+		}
+	}
+
+	/** A row lights while any of its ramps runs or has finished, in chain
+	    mode the row of the stage the envelopes are on.
+	*/
+	void stageLights() {
+		bool lit[8] = {};
+		bool ended[8] = {};
+		for (int g = 0; g < numGroups; g++) {
+			int isLit = simd::movemask((running[g] | holding[g] | finished[g]) & active[g]);
+			int isEnded = simd::movemask(endLight[g] & active[g]);
+			for (int l = 0; l < 4; l++) {
+				int row = chain ? stage[4 * g + l] : rampRow[4 * g + l];
+				lit[row] |= (isLit >> l) & 1;
+				ended[row] |= (isEnded >> l) & 1;
+			}
+		}
+		for (int r = 0; r < 8; r++) {
+			uiLights.set(START_LIGHT + r, lit[r] ? 10.f : 0.f);
+			uiLights.set(END_LIGHT + r, ended[r] ? 10.f : 0.f);
+		}
+	}
+
+	void process(const ProcessArgs& args) override {
+		if (chainRequested != chain) {
+			chain = chainRequested;
+			resetRamps();
+		}
+		// Groups whose curves are reseeded, all of them on a param pass.
+		uint32_t reseed = ~0u;
+		if (paramDivider.getClock() == 0) {
+			readParams(args.sampleRate);
+		}
+		else {
+			reseed = readCv(args.sampleRate);
+		}
+		paramDivider.process();
+		if (chain) {
+			processChain(args, reseed);
+		}
+		else {
+			processRamps(args, reseed);
+		}
+		frame++;
+		if (uiClock.process(args.sampleRate)) {
+			stageLights();
+			uiLights.flush([&](int i, float v) {
+				lights[i].setBrightness(v);
+			});
+		}
+	}
+
+	void processRamps(const ProcessArgs& args, uint32_t reseed) {
+		for (int g = 0; g < numGroups; g++) {
+			float_4 startIn;
+			float_4 stopIn;
+			readInputs(g, startIn, stopIn);
+			float_4 active = this->active[g];
+			float_4 started = trigger(startTrigger[g], startIn, active);
+			float_4 stopped = simd::movemask(hasStop[g]) ? trigger(stopTrigger[g], stopIn, active & hasStop[g]) : float_4::zero();
+			float_4 lastIn = lastStart[g];
+			lastStart[g] = startIn;
+			if (!wake(g, simd::movemask(started | stopped), args.sampleRate)) {
+				continue;
+			}
+			float_4 from = this->from[g];
+			float_4 to = this->to[g];
+			float_4 interp = this->interp[g];
+
+			running[g] |= started;
+			finished[g] &= ~started;
+			int isStarted = simd::movemask(started);
+			if (isStarted) {
+				float_4 offset = risingOffset(lastIn, startIn);
+				for (int l = 0; l < 4; l++) {
+					if ((isStarted >> l) & 1) {
+						startFrame[4 * g + l] = frame;
+						startOffset[4 * g + l] = offset[l];
+					}
 				}
-				if (running[i] == true) {
-					gc[i] += args.sampleTime;				
-					if (gc[i] < params[TIME_PARAM + i].getValue()) {
-						float current_voltage = interpolate(
-							gc[i], 
-							params[TIME_PARAM + i].getValue(), 
-							params[VFROM_PARAM + i].getValue(), 
-							params[VTO_PARAM + i].getValue(), 
-							params[INTERP_PARAM + i].getValue()
-						);		
-						outputs[VOUTU_OUTPUT + i].setVoltage(current_voltage);
-						outputs[VOUTB_OUTPUT + i].setVoltage(
-							rescale(current_voltage, 0.f, 10.f, -5.f, 5.f)
-						);
+				schedule(g, isStarted, args.sampleRate);
+			}
+
+			// running
+			float_4 isRunning = running[g] & active;
+			float_4 ends = float_4::zero();
+			if (frame >= groupEnd[g]) {
+				ends = isRunning & (lanes([&](int l) {return (frame >= endFrame[4 * g + l]) ? 1.f : 0.f;}) > 0.f);
+			}
+			float_4 inTime = isRunning & ~ends;
+			running[g] &= ~ends;
+			finished[g] |= ends;
+			endLight[g] |= ends;
+			if (simd::movemask(ends)) {
+				// The pulse started when the time was up, between frames.
+				float_4 late = lanes([&](int l) {return endExcess(4 * g + l, time[g][l], args.sampleRate);}) * args.sampleTime;
+				endPulseTime[g] = simd::ifelse(ends, simd::fmax(endPulseTime[g], 1e-3f - late), endPulseTime[g]);
+				schedule(g, 0, args.sampleRate);
+			}
+			if (simd::movemask(isRunning)) {
+				if (((reseed >> g) & 1) || isStarted) {
+					reseedCurves(g, args.sampleTime);
+				}
+				else {
+					advanceCurves(g);
+				}
+			}
+			if (simd::movemask(inTime)) {
+				outU[g] = simd::ifelse(inTime, interpolate(g, from, to, interp), outU[g]);
+			}
+
+			// finished
+			float_4 isFinished = finished[g] & active & ~isRunning;
+			if (simd::movemask(isFinished)) {
+				endPulse[g] = simd::ifelse(isFinished, endPulseTime[g] > 0.f, endPulse[g]);
+				endPulseTime[g] = simd::ifelse(isFinished & endPulse[g], endPulseTime[g] - args.sampleTime, endPulseTime[g]);
+				outEnd[g] = simd::ifelse(isFinished, simd::ifelse(endPulse[g], 10.f, 0.f), outEnd[g]);
+				outU[g] = simd::ifelse(isFinished, to, outU[g]);
+			}
+			outB[g] = simd::ifelse(inTime | isFinished, simd::rescale(outU[g], 0.f, 10.f, -5.f, 5.f), outB[g]);
+
+			// stopped
+			if (simd::movemask(stopped)) {
+				running[g] &= ~stopped;
+				finished[g] &= ~stopped;
+				endLight[g] &= ~stopped;
+				outEnd[g] = simd::ifelse(stopped, 0.f, outEnd[g]);
+				if (simd::movemask(stopped & isRunning)) {
+					schedule(g, 0, args.sampleRate);
+				}
+			}
+
+			// stopped or not connected
+			float_4 off = stopped | ~active;
+			if (simd::movemask(off)) {
+				outU[g] = simd::ifelse(off, 0.f, outU[g]);
+				outB[g] = simd::ifelse(off, 0.f, outB[g]);
+			}
+
+			writeOutputs(g, true);
+			// Busy until the end pulse of the last ramp that ended is over.
+			bool isBusy = simd::movemask((running[g] | (finished[g] & (endPulse[g] | (endPulseTime[g] > 0.f)))) & active);
+			busy = isBusy ? (busy | (1u << g)) : (busy & ~(1u << g));
+		}
+	}
+
+	/** Stops every ramp and clears the outputs, on a change of mode. The
+	    layout is redone on this sample.
+	*/
+	void resetRamps() {
+		for (int g = 0; g < maxGroups; g++) {
+			running[g] = 0.f;
+			finished[g] = 0.f;
+			holding[g] = 0.f;
+			endPulse[g] = 0.f;
+			endLight[g] = 0.f;
+			endPulseTime[g] = 0.f;
+			outU[g] = 0.f;
+			outB[g] = 0.f;
+			outEnd[g] = 0.f;
+			groupEnd[g] = INT64_MAX;
+		}
+		for (int r = 0; r < 8; r++) {
+			for (int g = 0; g < maxChannels / 4; g++) {
+				stagePulseTime[r][g] = 0.f;
+			}
+			for (int ch = 0; ch < maxChannels; ch++) {
+				outputs[END_OUTPUT + r].setVoltage(0.f, ch);
+				outputs[VOUTB_OUTPUT + r].setVoltage(0.f, ch);
+				outputs[VOUTU_OUTPUT + r].setVoltage(0.f, ch);
+			}
+			rowChannels[r] = 0;
+		}
+		stagePulses = 0;
+		busy = 0;
+		stale = 0;
+		refresh = ~0u;
+		paramDivider.reset();
+	}
+
+	/** Mask of lane l. */
+	static float_4 laneMask(int l) {
+		return lanes([&](int k) {return (k == l) ? 1.f : 0.f;}) > 0.f;
+	}
+
+	/** Starts envelope i on stage s from the voltage v, offset samples
+	    before this frame.
+	*/
+	void enterStage(int i, int s, float v, float offset, float sampleRate) {
+		int g = i / 4;
+		float_4 m = laneMask(i % 4);
+		stage[i] = s;
+		startFrame[i] = frame;
+		startOffset[i] = offset;
+		from[g] = simd::ifelse(m, v, from[g]);
+		to[g] = simd::ifelse(m, knob(TO_CV_INPUT, VTO_PARAM, i, 10.f), to[g]);
+		time[g] = simd::ifelse(m, timeKnob(i), time[g]);
+		interp[g] = simd::ifelse(m, interpKnob(i), interp[g]);
+		if (anyBezier) {
+			bezier[g] = simd::ifelse(m, bezierRow[s] ? float_4::mask() : float_4::zero(), bezier[g]);
+			for (int j = 0; j < 4; j++) {
+				curve[g][j] = simd::ifelse(m, rowCurve[s][j], curve[g][j]);
+			}
+		}
+		running[g] |= m;
+		holding[g] &= ~m;
+		finished[g] &= ~m;
+		schedule(g, 1 << (i % 4), sampleRate);
+	}
+
+	/** Ends envelope i at the voltage of its stage. */
+	void finishEnvelope(int i) {
+		int g = i / 4;
+		float_4 m = laneMask(i % 4);
+		running[g] &= ~m;
+		holding[g] &= ~m;
+		finished[g] |= m;
+		endLight[g] |= m;
+	}
+
+	/** Starts the end pulse of stage s for the lanes in m, late seconds
+	    after the stage ended.
+	*/
+	void pulseStage(int s, int g, float_4 m, float late) {
+		stagePulseTime[s][g] = simd::ifelse(m, simd::fmax(stagePulseTime[s][g], 1e-3f - late), stagePulseTime[s][g]);
+		stagePulses |= 1u << (4 * s + g);
+	}
+
+	/** Moves envelope i on from every stage that has ended by this frame,
+	    the next stage starts when the last one ended, between frames. A
+	    stage of time 0 passes on at once. Stops after two rounds of 8
+	    stages of time 0 in a loop, they go on on the next sample.
+	*/
+	void endStages(int i, float sampleRate) {
+		int g = i / 4;
+		int l = i % 4;
+		for (int n = 0; n < 16 && frame >= endFrame[i]; n++) {
+			int s = stage[i];
+			float excess = endExcess(i, time[g][l], sampleRate);
+			pulseStage(s, g, laneMask(l), excess / sampleRate);
+			bool gate = simd::movemask(startTrigger[g].state) & (1 << l);
+			bool sustainLoop = loopStage >= 0 && loopStage <= sustainStage;
+			int next = s + 1;
+			if (s == sustainStage && gate) {
+				if (!sustainLoop) {
+					running[g] &= ~laneMask(l);
+					holding[g] |= laneMask(l);
+					schedule(g, 0, sampleRate);
+					return;
+				}
+				next = loopStage;
+			}
+			else if (s == 7) {
+				if (loopStage < 0 || (sustainStage >= 0 && sustainLoop)) {
+					finishEnvelope(i);
+					schedule(g, 0, sampleRate);
+					return;
+				}
+				next = loopStage;
+			}
+			enterStage(i, next, to[g][l], excess, sampleRate);
+		}
+	}
+
+	/** The gate of envelope i fell before or on the sustain stage offset
+	    samples before this frame, it goes on with the stage after it from
+	    where it is.
+	*/
+	void release(int i, float offset, float sampleRate) {
+		int g = i / 4;
+		int l = i % 4;
+		if (sustainStage < 7) {
+			enterStage(i, sustainStage + 1, outU[g][l], offset, sampleRate);
+		}
+		else {
+			finishEnvelope(i);
+			schedule(g, 0, sampleRate);
+		}
+	}
+
+	/** Writes the stage end pulses still running, rows and groups with a
+	    pulse only.
+	*/
+	void processPulses(float sampleTime) {
+		for (int b = 0; b < 32 && stagePulses; b++) {
+			if (!((stagePulses >> b) & 1)) {
+				continue;
+			}
+			int s = b / 4;
+			int g = b % 4;
+			float_4 on = stagePulseTime[s][g] > 0.f;
+			outputs[END_OUTPUT + s].setVoltageSimd(simd::ifelse(on, 10.f, 0.f), 4 * g);
+			stagePulseTime[s][g] = simd::ifelse(on, stagePulseTime[s][g] - sampleTime, stagePulseTime[s][g]);
+			if (!simd::movemask(on)) {
+				stagePulses &= ~(1u << b);
+			}
+		}
+	}
+
+	/** Chain mode. The start input of row 1 is the gate, a rising edge
+	    starts the envelope on stage 1 from its From, a falling edge moves
+	    an envelope on or before the sustain stage to the stage after it.
+	    The stop input of row 1 stops the envelope.
+	*/
+	void processChain(const ProcessArgs& args, uint32_t reseed) {
+		for (int g = 0; g < numGroups; g++) {
+			float_4 startIn;
+			float_4 stopIn;
+			readInputs(g, startIn, stopIn);
+			float_4 active = this->active[g];
+			float_4 gate = startTrigger[g].state;
+			float_4 started = trigger(startTrigger[g], startIn, active);
+			float_4 released = gate & ~startTrigger[g].state & (running[g] | holding[g]) & active;
+			float_4 stopped = simd::movemask(hasStop[g]) ? trigger(stopTrigger[g], stopIn, active & hasStop[g]) : float_4::zero();
+			int isStarted = simd::movemask(started);
+			int isReleased = (sustainStage >= 0) ? simd::movemask(released) : 0;
+			float_4 lastIn = lastStart[g];
+			lastStart[g] = startIn;
+			if (!wake(g, isStarted | isReleased | simd::movemask(stopped), args.sampleRate)) {
+				continue;
+			}
+
+			// Stage changes are rare, lane by lane.
+			int changed = isStarted | isReleased;
+			if (changed) {
+				float_4 offset = simd::ifelse(started, risingOffset(lastIn, startIn), fallingOffset(lastIn, startIn));
+				for (int l = 0; l < 4 && 4 * g + l < numRamps; l++) {
+					int i = 4 * g + l;
+					if ((isStarted >> l) & 1) {
+						stage[i] = 0;
+						enterStage(i, 0, knob(FROM_CV_INPUT, VFROM_PARAM, i, 10.f), offset[l], args.sampleRate);
 					}
-					else {
-						running[i] = false;
-						finished[i] = true;
-						stopped[i] = false;
-						endPulseGen[i].trigger(1e-3f);
+					else if (((isReleased >> l) & 1) && stage[i] <= sustainStage) {
+						release(i, offset[l], args.sampleRate);
 					}
-					lights[START_LIGHT + i].setBrightness(10.f);
 				}
-				else if (finished[i] == true) {
-					endPulse[i] = endPulseGen[i].process(args.sampleTime);
-					outputs[END_OUTPUT + i].setVoltage(endPulse[i] ? 10.f : 0.f);
-					float current_voltage = params[VTO_PARAM + i].getValue();
-					outputs[VOUTU_OUTPUT + i].setVoltage(current_voltage);
-					outputs[VOUTB_OUTPUT + i].setVoltage(
-						rescale(current_voltage, 0.0 ,10.0, -5.0, 5.0)
-					);
-					lights[START_LIGHT + i].setBrightness(10.f);
-					lights[END_LIGHT + i].setBrightness(10.f);
+			}
+			if (frame >= groupEnd[g]) {
+				int isRunning = simd::movemask(running[g] & active);
+				for (int l = 0; l < 4; l++) {
+					if (((isRunning >> l) & 1) && frame >= endFrame[4 * g + l]) {
+						endStages(4 * g + l, args.sampleRate);
+						changed |= 1 << l;
+					}
 				}
-				if (inputs[STOP_INPUT + i].isConnected() && stopTrigger[i].process(inputs[STOP_INPUT + i].getVoltage()) == true) {
-					gc[i] = 0;
-					running[i] = false;
-					finished[i] = false;
-					stopped[i] = true;
-					outputs[END_OUTPUT + i].setVoltage(0.f);
-					outputs[VOUTU_OUTPUT + i].setVoltage(0.f);
-					outputs[VOUTB_OUTPUT + i].setVoltage(0.f);
-					lights[END_LIGHT + i].setBrightness(0.f);
-					lights[START_LIGHT + i].setBrightness(0.f);
+			}
+
+			float_4 isRunning = running[g] & active;
+			if (simd::movemask(isRunning)) {
+				if (((reseed >> g) & 1) || changed) {
+					reseedCurves(g, args.sampleTime);
 				}
+				else {
+					advanceCurves(g);
+				}
+				outU[g] = simd::ifelse(isRunning, interpolate(g, from[g], to[g], interp[g]), outU[g]);
 			}
-			else {
-				outputs[VOUTU_OUTPUT + i].setVoltage(0.f);
-				outputs[VOUTB_OUTPUT + i].setVoltage(0.f);
-				lights[END_LIGHT + i].setBrightness(0.f);
-				lights[START_LIGHT + i].setBrightness(0.f);
-				gc[i] = 0;
+			float_4 resting = (holding[g] | finished[g]) & active;
+			outU[g] = simd::ifelse(resting, to[g], outU[g]);
+			outB[g] = simd::ifelse(isRunning | resting, simd::rescale(outU[g], 0.f, 10.f, -5.f, 5.f), outB[g]);
+
+			// stopped or not connected
+			if (simd::movemask(stopped)) {
+				running[g] &= ~stopped;
+				holding[g] &= ~stopped;
+				finished[g] &= ~stopped;
+				endLight[g] &= ~stopped;
+				for (int s = 0; s < 8; s++) {
+					stagePulseTime[s][g] = simd::ifelse(stopped, 0.f, stagePulseTime[s][g]);
+				}
+				schedule(g, 0, args.sampleRate);
 			}
+			float_4 off = stopped | ~active;
+			outU[g] = simd::ifelse(off, 0.f, outU[g]);
+			outB[g] = simd::ifelse(off, 0.f, outB[g]);
+
+			writeOutputs(g, false);
+			bool isBusy = simd::movemask(running[g] & active);
+			busy = isBusy ? (busy | (1u << g)) : (busy & ~(1u << g));
+		}
+		processPulses(args.sampleTime);
+	}
+
+	json_t* dataToJson() override {
+		json_t* rootJ = json_object();
+		json_object_set_new(rootJ, "uiRate", uiClock.toJson());
+		json_object_set_new(rootJ, "chain", json_boolean(chainRequested));
+		json_object_set_new(rootJ, "sustain", json_integer(sustainStage));
+		json_object_set_new(rootJ, "loop", json_integer(loopStage));
+		json_t* bezierJ = json_array();
+		for (int r = 0; r < 8; r++) {
+			json_array_append_new(bezierJ, json_boolean(bezierRow[r]));
+		}
+		json_object_set_new(rootJ, "bezier", bezierJ);
+		return rootJ;
+	}
+
+	void dataFromJson(json_t* rootJ) override {
+		uiClock.fromJson(json_object_get(rootJ, "uiRate"));
+		chainRequested = json_is_true(json_object_get(rootJ, "chain"));
+		json_t* sustainJ = json_object_get(rootJ, "sustain");
+		if (sustainJ) {
+			sustainStage = clamp((int) json_integer_value(sustainJ), -1, 7);
+		}
+		json_t* loopJ = json_object_get(rootJ, "loop");
+		if (loopJ) {
+			loopStage = clamp((int) json_integer_value(loopJ), -1, 7);
+		}
+		json_t* bezierJ = json_object_get(rootJ, "bezier");
+		for (int r = 0; r < 8; r++) {
+			bezierRow[r] = json_is_true(json_array_get(bezierJ, r));
 		}
 	}
 };
@@ -190,6 +1248,11 @@ struct RampWidget : ModuleWidget {
 		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(18.0, 106.5)), module, Ramp::STOP_INPUT + 6));
 		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(18.0, 118.5)), module, Ramp::STOP_INPUT + 7));
 
+		addInput(createInputCentered<GreySmallPort>(mm2px(Vec(30.0, 19.0)), module, Ramp::FROM_CV_INPUT));
+		addInput(createInputCentered<GreySmallPort>(mm2px(Vec(42.0, 19.0)), module, Ramp::TO_CV_INPUT));
+		addInput(createInputCentered<GreySmallPort>(mm2px(Vec(54.0, 19.0)), module, Ramp::TIME_CV_INPUT));
+		addInput(createInputCentered<GreySmallPort>(mm2px(Vec(66.0, 19.0)), module, Ramp::INTERP_CV_INPUT));
+
 		addParam(createParamCentered<GreyHoleKnob>(mm2px(Vec(30.0,  34.5)), module, Ramp::VFROM_PARAM + 0));
 		addParam(createParamCentered<GreyHoleKnob>(mm2px(Vec(30.0,  46.5)), module, Ramp::VFROM_PARAM + 1));
 		addParam(createParamCentered<GreyHoleKnob>(mm2px(Vec(30.0,  58.5)), module, Ramp::VFROM_PARAM + 2));
@@ -262,6 +1325,125 @@ struct RampWidget : ModuleWidget {
 		addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(98.0, 106.5)), module, Ramp::VOUTU_OUTPUT + 6));
 		addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(98.0, 118.5)), module, Ramp::VOUTU_OUTPUT + 7));
 	}
+
+	struct ChainItem : MenuItem {
+		Ramp* module;
+		void onAction(const event::Action& e) override {
+			module->chainRequested ^= true;
+		}
+	};
+
+	struct StageItem : MenuItem {
+		int* stage;
+		int value;
+		void onAction(const event::Action& e) override {
+			*stage = value;
+		}
+	};
+
+	/** Submenu to pick a stage or none. */
+	struct StageMenuItem : MenuItem {
+		int* stage;
+		Menu* createChildMenu() override {
+			Menu* menu = new Menu;
+			for (int s = -1; s < 8; s++) {
+				std::string label = (s < 0) ? "None" : "Stage " + std::to_string(s + 1);
+				StageItem* item = createMenuItem<StageItem>(label, CHECKMARK(*stage == s));
+				item->stage = stage;
+				item->value = s;
+				menu->addChild(item);
+			}
+			return menu;
+		}
+	};
+
+	/** Menu slider of a Bezier handle, the param has no knob. */
+	struct HandleQuantity : Quantity {
+		Ramp* module;
+		int paramId;
+		void setValue(float value) override {
+			module->params[paramId].setValue(clamp(value, getMinValue(), getMaxValue()));
+		}
+		float getValue() override {
+			return module->params[paramId].getValue();
+		}
+		float getMinValue() override {
+			return -1.f;
+		}
+		float getMaxValue() override {
+			return 2.f;
+		}
+		float getDefaultValue() override {
+			return (paramId < Ramp::HANDLE2_PARAM) ? 1.f / 3.f : 2.f / 3.f;
+		}
+		std::string getLabel() override {
+			return (paramId < Ramp::HANDLE2_PARAM) ? "Handle 1" : "Handle 2";
+		}
+		int getDisplayPrecision() override {
+			return 3;
+		}
+	};
+
+	struct HandleSlider : ui::Slider {
+		HandleSlider(Ramp* module, int paramId) {
+			HandleQuantity* q = new HandleQuantity;
+			q->module = module;
+			q->paramId = paramId;
+			quantity = q;
+			box.size.x = 180.f;
+		}
+		~HandleSlider() {
+			delete quantity;
+		}
+	};
+
+	struct BezierItem : MenuItem {
+		bool* bezier;
+		void onAction(const event::Action& e) override {
+			*bezier ^= true;
+		}
+	};
+
+	/** Submenu of a row, the Bezier curve on or off and its two handles. */
+	struct RowCurveItem : MenuItem {
+		Ramp* module;
+		int row;
+		Menu* createChildMenu() override {
+			Menu* menu = new Menu;
+			BezierItem* item = createMenuItem<BezierItem>("Bezier curve", CHECKMARK(module->bezierRow[row]));
+			item->bezier = &module->bezierRow[row];
+			menu->addChild(item);
+			menu->addChild(new HandleSlider(module, Ramp::HANDLE1_PARAM + row));
+			menu->addChild(new HandleSlider(module, Ramp::HANDLE2_PARAM + row));
+			return menu;
+		}
+	};
+
+	void appendContextMenu(Menu* menu) override {
+		Ramp* module = dynamic_cast<Ramp*>(this->module);
+
+		menu->addChild(new MenuSeparator);
+		ChainItem* chainItem = createMenuItem<ChainItem>("Chain rows as envelope stages", CHECKMARK(module->chainRequested));
+		chainItem->module = module;
+		menu->addChild(chainItem);
+		StageMenuItem* sustainItem = createMenuItem<StageMenuItem>("Sustain", RIGHT_ARROW);
+		sustainItem->stage = &module->sustainStage;
+		menu->addChild(sustainItem);
+		StageMenuItem* loopItem = createMenuItem<StageMenuItem>("Loop from", RIGHT_ARROW);
+		loopItem->stage = &module->loopStage;
+		menu->addChild(loopItem);
+
+		menu->addChild(new MenuSeparator);
+		menu->addChild(createMenuLabel("Bezier curves, 0 to 1 through the handles"));
+		for (int r = 0; r < 8; r++) {
+			RowCurveItem* rowItem = createMenuItem<RowCurveItem>("Row " + std::to_string(r + 1), RIGHT_ARROW);
+			rowItem->module = module;
+			rowItem->row = r;
+			menu->addChild(rowItem);
+		}
+
+		appendUiRateMenu(menu, &module->uiClock);
+	}
 };
 
 Model* modelRamp = createModel<Ramp, RampWidget>("Ramp");
\ No newline at end of file
@@ -0,0 +1,151 @@
+#pragma once
+#include <rack.hpp>
+
+using namespace rack;
+
+/** Cubic Bezier kernels shared by the oscillators.
+  T is the value type, float, double, simd::float_4 or a point type with
+  + and - and * by S, S is the type of the parameter t. The control points
+  P[0..3] are in Bernstein form, the coefficients K[0..3] = {a, b, c, d} in
+  power basis, B(t) = at^3 + bt^2 + ct + d. A segment played at audio rate
+  from fixed points is best converted once and evaluated by Horner's scheme,
+  points that change every sample by de Casteljau.
+*/
+
+/** Power basis coefficients of the segment P. */
+template <typename T>
+inline void bezierCoefs(const T* P, T* K) {
+  K[0] = P[3] - P[0] + (P[1] - P[2]) * 3.f;
+  K[1] = (P[2] - P[1] - P[1] + P[0]) * 3.f;
+  K[2] = (P[1] - P[0]) * 3.f;
+  K[3] = P[0];
+}
+
+/** Control points of the segment with the coefficients K. */
+template <typename T>
+inline void bezierPoints(const T* K, T* P) {
+  P[0] = K[3];
+  P[1] = K[3] + K[2] * (1.f / 3.f);
+  P[2] = P[1] + (K[2] + K[1]) * (1.f / 3.f);
+  P[3] = K[0] + K[1] + K[2] + K[3];
+}
+
+/** Position, B(t) = ((at + b)t + c)t + d. */
+template <typename T, typename S>
+inline T bezierHorner(const T* K, S t) {
+  return ((K[0] * t + K[1]) * t + K[2]) * t + K[3];
+}
+
+/** First derivative, B'(t) = (3at + 2b)t + c. */
+template <typename T, typename S>
+inline T bezierHornerTangent(const T* K, S t) {
+  return (K[0] * (t * 3.f) + K[1] * 2.f) * t + K[2];
+}
+
+/** Second derivative, B''(t) = 6at + 2b. */
+template <typename T, typename S>
+inline T bezierHornerCurvature(const T* K, S t) {
+  return K[0] * (t * 6.f) + K[1] * 2.f;
+}
+
+/** Position by de Casteljau, three rounds of linear interpolation. */
+template <typename T, typename S>
+inline T bezierPoint(const T* P, S t) {
+  T a = P[0] + (P[1] - P[0]) * t;
+  T b = P[1] + (P[2] - P[1]) * t;
+  T c = P[2] + (P[3] - P[2]) * t;
+  a = a + (b - a) * t;
+  b = b + (c - b) * t;
+  return a + (b - a) * t;
+}
+
+/** First derivative from the control points, the quadratic of the
+  differences, B'(t) = 3 (Q1 - Q0) with the second round of de Casteljau.
+*/
+template <typename T, typename S>
+inline T bezierTangent(const T* P, S t) {
+  T d0 = P[1] - P[0];
+  T d1 = P[2] - P[1];
+  T d2 = P[3] - P[2];
+  T a = d0 + (d1 - d0) * t;
+  T b = d1 + (d2 - d1) * t;
+  return (a + (b - a) * t) * 3.f;
+}
+
+/** Second derivative from the control points, the line of the second
+  differences.
+*/
+template <typename T, typename S>
+inline T bezierCurvature(const T* P, S t) {
+  T e0 = P[2] - P[1] - P[1] + P[0];
+  T e1 = P[3] - P[2] - P[2] + P[1];
+  return (e0 + (e1 - e0) * t) * 6.f;
+}
+
+/** Splits the segment P at t into L on [0, t] and R on [t, 1], both
+  reparameterized to [0, 1]. L and R may not alias P.
+*/
+template <typename T, typename S>
+inline void bezierSplit(const T* P, S t, T* L, T* R) {
+  T a = P[0] + (P[1] - P[0]) * t;
+  T b = P[1] + (P[2] - P[1]) * t;
+  T c = P[2] + (P[3] - P[2]) * t;
+  T ab = a + (b - a) * t;
+  T bc = b + (c - b) * t;
+  T m = ab + (bc - ab) * t;
+  L[0] = P[0];
+  L[1] = a;
+  L[2] = ab;
+  L[3] = m;
+  R[0] = m;
+  R[1] = bc;
+  R[2] = c;
+  R[3] = P[3];
+}
+
+/** Least squares segment for the m segments P[0..m-1] played one after
+  the other on [0, 1], through their outer knots. The handles minimize the
+  squared distance over [0, 1], integrated by four point Gauss-Legendre on
+  every segment, exact for the degree 6 integrands. Exact when the segments
+  are pieces of one cubic.
+*/
+template <typename T>
+inline void bezierFit(const T (*P)[4], int m, T* out) {
+  static const float nodes[4] = {0.0694318442f, 0.3300094782f, 0.6699905218f, 0.9305681558f};
+  static const float weights[4] = {0.1739274226f, 0.3260725774f, 0.3260725774f, 0.1739274226f};
+  T p0 = P[0][0];
+  T p3 = P[m - 1][3];
+  T r1 = p0 - p0;
+  T r2 = r1;
+  for (int k = 0; k < m; k++) {
+    for (int q = 0; q < 4; q++) {
+      float u = (k + nodes[q]) / m;
+      float v = 1.f - u;
+      T d = (bezierPoint(P[k], nodes[q]) - p0 * (v * v * v) - p3 * (u * u * u)) * (weights[q] / m);
+      r1 = r1 + d * (3.f * u * v * v);
+      r2 = r2 + d * (3.f * u * u * v);
+    }
+  }
+  // Gram matrix of the two inner Bernstein polynomials, 3/35 on the
+  // diagonal, 9/140 off it.
+  const float a = 3.f / 35.f;
+  const float c = 9.f / 140.f;
+  const float det = a * a - c * c;
+  out[0] = p0;
+  out[1] = (r1 * a - r2 * c) * (1.f / det);
+  out[2] = (r2 * a - r1 * c) * (1.f / det);
+  out[3] = p3;
+}
+
+/** Integral of a cubic Bezier segment from 0 to t, a quartic in Bernstein
+  form with the points 0, P0/4, (P0+P1)/4, (P0+P1+P2)/4, (P0+..+P3)/4.
+*/
+template <typename T, typename S>
+inline T bezierIntegral(const T* P, S t) {
+  S tm = 1.f - t;
+  S t2 = t * t;
+  T S1 = P[0] + P[1];
+  T S2 = S1 + P[2];
+  T S3 = S2 + P[3];
+  return (P[0] * (tm * tm * tm) + S1 * (1.5f * t * tm * tm) + S2 * (t2 * tm) + S3 * (0.25f * t2 * t)) * t;
+}
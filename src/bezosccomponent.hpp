@@ -40,6 +40,41 @@ namespace rack {
     }
   };
 
+  /** Knob that draws a value the module derived instead of its param while
+      *shown is not NaN, the param itself is left alone. shown is NULL in
+      the module browser.
+  */
+  template <typename TBase>
+  struct ShownValueKnob : TBase {
+    const float* shown = NULL;
+    float drawn = NAN;
+
+    void step() override {
+      float value = shown ? *shown : NAN;
+      if (value != drawn && !(std::isnan(value) && std::isnan(drawn))) {
+        drawn = value;
+        event::Change eChange;
+        this->onChange(eChange);
+      }
+      TBase::step();
+    }
+
+    /** SvgKnob::onChange with the drawn value. */
+    void onChange(const event::Change& e) override {
+      if (std::isnan(drawn) || !this->paramQuantity) {
+        TBase::onChange(e);
+        return;
+      }
+      float angle = math::rescale(drawn, this->paramQuantity->getMinValue(), this->paramQuantity->getMaxValue(), this->minAngle, this->maxAngle);
+      this->tw->identity();
+      math::Vec center = this->sw->box.getCenter();
+      this->tw->translate(center);
+      this->tw->rotate(angle);
+      this->tw->translate(center.neg());
+      this->fb->dirty = true;
+    }
+  };
+
   struct PJ301MSPort : SvgPort {
     PJ301MSPort() {
       setSvg(APP->window->loadSvg(asset::plugin(pluginInstance,"res/BezoscLib/PJ301MS.svg")));
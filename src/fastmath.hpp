@@ -0,0 +1,33 @@
+#pragma once
+#include <rack.hpp>
+
+using namespace rack;
+using simd::float_4;
+
+/** Polynomial atan2 on four lanes.
+  Octant reduction to |z| <= 1 and the 9th order approximation of
+  Abramowitz & Stegun 4.4.49, max. error 1.2e-5 rad in float.
+  atan2(0, 0) returns 0.
+*/
+inline float_4 fastAtan2(float_4 y, float_4 x) {
+  float_4 ax = simd::abs(x);
+  float_4 ay = simd::abs(y);
+  float_4 mx = simd::fmax(ax, ay);
+  float_4 mn = simd::fmin(ax, ay);
+  float_4 z = simd::ifelse(mx > 0.f, mn / mx, 0.f);
+  float_4 z2 = z * z;
+  float_4 r = z * (0.9998660f + z2 * (-0.3302995f + z2 * (0.1801410f + z2 * (-0.0851330f + z2 * 0.0208351f))));
+  r = simd::ifelse(ay > ax, float(M_PI / 2) - r, r);
+  r = simd::ifelse(x < 0.f, float(M_PI) - r, r);
+  return simd::ifelse(y < 0.f, -r, r);
+}
+
+/** sqrt(x^2 + y^2) on four lanes from the rsqrt estimate and one
+  Newton-Raphson step, max. relative error 1e-6.
+*/
+inline float_4 fastHypot(float_4 x, float_4 y) {
+  float_4 s = x * x + y * y;
+  float_4 r = simd::rsqrt(s);
+  r = r * (1.5f - 0.5f * s * r * r);
+  return simd::ifelse(s > 0.f, s * r, 0.f);
+}
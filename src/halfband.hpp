@@ -0,0 +1,103 @@
+#pragma once
+#include <rack.hpp>
+
+using namespace rack;
+
+/** Polyphase half-band decimator, halves the sample rate.
+  The half-band FIR has 4K-1 taps. Apart from the centre tap (1/2) every
+  other tap is zero, so one input phase is only delayed and the other phase
+  runs a symmetric 2K tap filter, K multiplies per output.
+  T is float or simd::float_4.
+*/
+template <int K, typename T>
+struct HalfBandDecimator {
+  static const int numTaps = 2 * K;
+
+  float taps[K];
+  T odd[2 * numTaps];
+  T even[K];
+  int pos = 0;
+  int evenPos = 0;
+
+  HalfBandDecimator() {
+    // Blackman-Harris windowed sinc, h[j] = sinc((j - M) / 2) / 2, M = 2K - 1.
+    const int length = 4 * K - 1;
+    const int M = 2 * K - 1;
+    float sum = 0.f;
+    for (int i = 0; i < K; i++) {
+      int j = 2 * i;
+      float x = (j - M) * 0.5f;
+      float sinc = std::sin(M_PI * x) / (M_PI * x);
+      float p = 2 * M_PI * (j + 1) / (length + 1);
+      float w = 0.35875f - 0.48829f * std::cos(p) + 0.14128f * std::cos(2 * p) - 0.01168f * std::cos(3 * p);
+      taps[i] = 0.5f * sinc * w;
+      sum += 2 * taps[i];
+    }
+    // DC gain of the filtered phase must be 1/2.
+    for (int i = 0; i < K; i++) {
+      taps[i] *= 0.5f / sum;
+    }
+    reset();
+  }
+
+  void reset() {
+    for (int i = 0; i < 2 * numTaps; i++) {
+      odd[i] = 0.f;
+    }
+    for (int i = 0; i < K; i++) {
+      even[i] = 0.f;
+    }
+  }
+
+  /** Takes two consecutive input samples, returns one output sample. */
+  T process(T in0, T in1) {
+    even[evenPos] = in0;
+    evenPos = (evenPos + 1) % K;
+    T delayed = even[evenPos];
+
+    pos = (pos + numTaps - 1) % numTaps;
+    odd[pos] = in1;
+    odd[pos + numTaps] = in1;
+    const T* w = &odd[pos];
+    T out = 0.f;
+    for (int i = 0; i < K; i++) {
+      out += taps[i] * (w[i] + w[numTaps - 1 - i]);
+    }
+    return out + 0.5f * delayed;
+  }
+};
+
+/** Decimates by 2, 4 or 8 with a cascade of half-band stages.
+  Only the last stage, closest to the output rate, needs a sharp transition,
+  the earlier ones get away with a few taps.
+*/
+template <typename T>
+struct CascadeDecimator {
+  static const int maxFactor = 8;
+
+  HalfBandDecimator<2, T> first;
+  HalfBandDecimator<3, T> middle;
+  HalfBandDecimator<8, T> last;
+
+  void reset() {
+    first.reset();
+    middle.reset();
+    last.reset();
+  }
+
+  /** Takes factor input samples, returns one output sample. */
+  T process(const T* in, int factor) {
+    if (factor == 8) {
+      T a = middle.process(first.process(in[0], in[1]), first.process(in[2], in[3]));
+      T b = middle.process(first.process(in[4], in[5]), first.process(in[6], in[7]));
+      return last.process(a, b);
+    }
+    if (factor == 4) {
+      return last.process(middle.process(in[0], in[1]), middle.process(in[2], in[3]));
+    }
+    if (factor == 2) {
+      return last.process(in[0], in[1]);
+    }
+    return in[0];
+  }
+};
@@ -11,4 +11,11 @@ namespace rack {
     }
   };
 
+  /** Compact port for the CV overrides above the knob columns. */
+  struct GreySmallPort : SvgPort {
+    GreySmallPort() {
+      setSvg(APP->window->loadSvg(asset::plugin(pluginInstance,"res/RampLibrary/SmallPort.svg")));
+    }
+  };
+
 }
\ No newline at end of file
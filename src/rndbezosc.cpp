@@ -1,7 +1,10 @@
 #include "plugin.hpp"
 #include "random.hpp"
 #include "rndbezosccomponent.hpp"
-#include <array>
+#include "splinecore.hpp"
+#include "bezier.hpp"
+#include "splineshare.hpp"
+#include "xoroshiro.hpp"
 
 using simd::float_4;
 
@@ -10,6 +13,7 @@ struct Rndbezosc : Module {
     PMORPH_PARAM,
 		PFREQ_PARAM,
     STYLE_PARAM,
+    MORPHTIME_PARAM,
 		NUM_PARAMS
 	};
 	enum InputIds {
@@ -24,129 +28,390 @@ struct Rndbezosc : Module {
 		NUM_LIGHTS
 	};
 
-  static const int numSegments = 4;
-  static const int pointsSegment = 4;
-  static const int numPoints = numSegments * pointsSegment;
-
-
-  int morphSteps = 0;
-  int morphStep = 0;
-  int tSteps = 0;
-  float tStep = 0.f;
-  float pitchOld = 0.f;
-  std::array<simd::float_4, numSegments> bezierMorph = genSmoothSpline();
-  std::array<simd::float_4, numSegments> bezierTarget;
-  std::array<simd::float_4, numSegments> morph;
-
-  inline std::array<simd::float_4, numSegments> genSmoothSpline(){
-    std::array<simd::float_4, numSegments> bezier;
-    std::array<float, 2*pointsSegment> rndp;
-    for (int i = 0; i < 2*pointsSegment; i++){rndp[i] = random::uniform();}
-    simd::float_4 tmp = simd::rescale({rndp[4],rndp[5],rndp[6],rndp[7]}, 0, 1,-2.5, 2.5);
-    bezier[0] = simd::rescale({rndp[0],rndp[1],rndp[2],rndp[3]}, 0, 1,-2.5, 2.5);
-    bezier[1][0] = bezier[0][3];                                 // B  Knot
-    bezier[1][1] = bezier[0][3] - (bezier[0][2] - bezier[0][3]); // Bc Handle
-    bezier[1][2] = tmp[0];                                       // Cb Handle
-    bezier[1][3] = tmp[1];                                       // C  Knot
-    bezier[2][0] = bezier[1][3];                                 // C  Knot
-    bezier[2][1] = bezier[1][3] - (bezier[1][2] - bezier[1][3]); // Cd Handle
-    bezier[2][2] = tmp[3];                                       // Dc Handle
-    bezier[2][3] = tmp[4];                                       // D  Knot
-    bezier[3][0] = bezier[2][3];                                 // D  Knot
-    bezier[3][1] = bezier[2][3] - (bezier[2][2] - bezier[2][3]); // Da Handle
-    bezier[3][2] = bezier[0][0] - (bezier[0][1] - bezier[0][0]); // Ad Handle
-    bezier[3][3] = bezier[0][0];                                 // A  Knot
-    return bezier;
-  }
+  static const int maxVoices = 16;
+  static const int maxSegments = 16;
 
-  inline std::array<simd::float_4, numSegments> genWildSpline(){
-    std::array<simd::float_4, numSegments> bezier;
-    std::array<float, numPoints> rndp;
-    for (int i = 0; i < numPoints; i++){rndp[i] = random::uniform();}
-    bezier[0] = simd::rescale({rndp[0],rndp[1],rndp[2],rndp[3]}, 0, 1,-2.5, 2.5);
-    bezier[1] = simd::rescale({rndp[4],rndp[5],rndp[6],rndp[7]}, 0, 1,-2.5, 2.5);
-    bezier[2] = simd::rescale({rndp[8],rndp[9],rndp[10],rndp[11]}, 0, 1,-2.5, 2.5);
-    bezier[3] = simd::rescale({rndp[12],rndp[13],rndp[14],rndp[15]}, 0, 1,-2.5, 2.5);
-    return bezier;
-  }
+  // One core per segment count, only the active one runs.
+  SplineCore<2> core2;
+  SplineCore<4> core4;
+  SplineCore<8> core8;
+  SplineCore<16> core16;
+  int activeSegments = 4;
 
-  inline std::array<simd::float_4, numSegments> genHalfWildSpline(){
-    std::array<simd::float_4, numSegments> bezier;
-    std::array<float, numPoints> rndp;
-    for (int i = 0; i < 10; i++){rndp[i] = random::uniform();}
-    bezier[0] = simd::rescale({rndp[0],rndp[1],rndp[2],rndp[3]}, 0, 1,-2.5, 2.5);
-    bezier[1] = simd::rescale({rndp[4],rndp[5],rndp[6],rndp[7]}, 0, 1,-2.5, 2.5);
-    bezier[2][0] = bezier[1][3];                                 // C  Knot
-    bezier[2][1] = bezier[1][3] - (bezier[1][2] - bezier[1][3]); // Cd Handle
-    bezier[2][2] = rescale(rndp[8], 0, 1,-2.5, 2.5);             // Dc Handle
-    bezier[2][3] = rescale(rndp[8], 0, 1,-2.5, 2.5);             // D  Knot
-    bezier[3][0] = bezier[2][3];                                 // D  Knot
-    bezier[3][1] = bezier[2][3] - (bezier[2][2] - bezier[2][3]); // Da Handle
-    bezier[3][2] = bezier[0][0] - (bezier[0][1] - bezier[0][0]); // Ad Handle
-    bezier[3][3] = bezier[0][0];                                 // A  Knot
-    return bezier;
-  }
+  // Phase in segments of every voice.
+  float_4 tStep[4] = {};
+  // Antiderivative anti-aliasing of the output.
+  bool adaa = false;
+  // Normalized morph position of every voice and its speed in 1/s, taken
+  // from the morph time when the morph starts.
+  float_4 morphPos[4] = {};
+  float_4 morphSpeed[4] = {};
+
+  enum Easing {
+    EASE_LINEAR,
+    EASE_SMOOTH,
+    EASE_EXP,
+    NUM_EASINGS
+  };
+  static const int easeSize = 256;
+  float easeTable[NUM_EASINGS][easeSize + 1];
+  int easing = EASE_LINEAR;
+
+  // Per instance generator, the seed is saved with the patch so renders 
+  // can be reproduced. The audio thread only pops blocks of uniforms from 
+  // the pool and refills it by refillDraws uniforms per sample, enough
+  // for 16 voices of 16 segments at the shortest morph time.
+  struct RandomBlock {
+    float u[maxSegments * 4];
+  };
+  uint64_t seed = 0;
+  Xoroshiro128Plus rng;
+  dsp::RingBuffer<RandomBlock, 32> pool;
+  // Block being refilled, its first refilled uniforms are drawn.
+  static const int refillDraws = 16;
+  RandomBlock refill;
+  int refilled = 0;
+  // Set from the menu or the patch, the audio thread takes them over 
+  // on the next restart, seed and activeSegments are its own.
+  std::atomic<uint64_t> pendingSeed {0};
+  std::atomic<int> pendingSegments {4};
+  std::atomic<bool> restartRequested {false};
+
+  // Serial of the last spline passed to a Bezosc on the right, see
+  // splineshare.hpp. The spline is passed again only when the eased
+  // morph position of voice 1 or 2, their target or the neighbour changed,
+  // -1 forces it.
+  uint32_t publishSerial = 0;
+  float publishedEase[2] = {-1.f, -1.f};
+  int publishTarget = -1;
 
   Rndbezosc() {
     config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
-    configParam(PMORPH_PARAM, 100, 5000, 2000, "Morph steps");
+    // Morph steps of old patches, no knob. Converted to the morph time
+    // once and set to 0 then.
+    configParam(PMORPH_PARAM, 0, 5000, 0, "Morph steps");
     configParam(PFREQ_PARAM, -3.5f, 3.5f, 0.f, "Frequency", "Hz");
     configParam(STYLE_PARAM, 0.f, 2.f, 0.f, "Modus");
+    configParam(MORPHTIME_PARAM, 2.f, 120.f, 45.f, "Morph time", " ms");
+    for (int i = 0; i <= easeSize; i++){
+      float x = (float) i / easeSize;
+      easeTable[EASE_LINEAR][i] = x;
+      easeTable[EASE_SMOOTH][i] = x * x * (3.f - 2.f * x);
+      easeTable[EASE_EXP][i] = (1.f - std::exp(-5.f * x)) / (1.f - std::exp(-5.f));
+    }
+    pendingSeed = random::u64();
+    restart();
+  }
+
+  /** Old patches count the morph in samples, they were made at 44.1 kHz.
+      Converted once, when a patch or preset is loaded.
+  */
+  void convertLegacyMorph(){
+    float steps = params[PMORPH_PARAM].getValue();
+    if (steps > 0.f){
+      params[MORPHTIME_PARAM].setValue(clamp(steps / 44.1f, 2.f, 120.f));
+      params[PMORPH_PARAM].setValue(0.f);
+    }
+  }
+
+  /** Eased morph position of four voices, linear lookup in the table. */
+  float_4 ease(float_4 pos){
+    if (easing == EASE_LINEAR){
+      return pos;
+    }
+    const float* table = easeTable[easing];
+    float_4 x = simd::clamp(pos, 0.f, 1.f) * easeSize;
+    float_4 out;
+    for (int l = 0; l < 4; l++){
+      int i = std::min((int) x[l], easeSize - 1);
+      out[l] = table[i] + (table[i + 1] - table[i]) * (x[l] - i);
+    }
+    return out;
+  }
+
+  /** Every target takes one block, whatever the style, so the sequence 
+      only depends on the seed and the segment count. Completes the block
+      being refilled, the draws stay in order.
+  */
+  RandomBlock nextBlock(){
+    for (; refilled < activeSegments * 4; refilled++){
+      refill.u[refilled] = rng.uniform();
+    }
+    refilled = 0;
+    return refill;
+  }
+
+  /** Draws the next refillDraws uniforms of the refill block, it goes to
+      the pool when complete.
+  */
+  void refillPool(){
+    if (pool.full()){
+      return;
+    }
+    int end = std::min(refilled + refillDraws, activeSegments * 4);
+    for (; refilled < end; refilled++){
+      refill.u[refilled] = rng.uniform();
+    }
+    if (refilled == activeSegments * 4){
+      pool.push(refill);
+      refilled = 0;
+    }
+  }
+
+  /** Starts over from the seed, new initial splines and a full pool. */
+  void restart(){
+    seed = pendingSeed;
+    activeSegments = pendingSegments;
+    rng.seed(seed);
+    pool.clear();
+    refilled = 0;
+    switch (activeSegments){
+      case 2: restartSpline(core2); break;
+      case 8: restartSpline(core8); break;
+      case 16: restartSpline(core16); break;
+      default: restartSpline(core4); break;
+    }
+    for (int g = 0; g < 4; g++){
+      tStep[g] = 0.f;
+    }
+    publishedEase[0] = publishedEase[1] = -1.f;
+  }
+
+  template <int N>
+  void restartSpline(SplineCore<N>& core){
+    for (int v = 0; v < maxVoices; v++){
+      RandomBlock block = nextBlock();
+      core.setTarget(v, 0, block.u);
+    }
+    while (!pool.full()){
+      pool.push(nextBlock());
+    }
+    int modus = params[STYLE_PARAM].getValue();
+    for (int v = 0; v < maxVoices; v++){
+      newTarget(core, v, modus);
+      // The voices start at different positions of their first morph, so 
+      // they run out of phase from the start.
+      morphPos[v / 4][v % 4] = (float) v / maxVoices;
+    }
+  }
+
+  /** New random target for voice v, the morph starts from the last target. */
+  template <int N>
+  void newTarget(SplineCore<N>& core, int v, int modus){
+    RandomBlock block = pool.empty() ? nextBlock() : pool.shift();
+    core.newTarget(v, modus, block.u);
+    if (v < 2){
+      publishedEase[v] = -1.f;
+    }
+    morphSpeed[v / 4][v % 4] = 1000.f / params[MORPHTIME_PARAM].getValue();
+    morphPos[v / 4][v % 4] = 0.f;
   }
 
 	void process(const ProcessArgs& args) override {
-		if(outputs[OUT_OUTPUT].isConnected()){
-
-      float pitch = rack::simd::ifelse(
-         inputs[IFREQ_INPUT].isConnected()
-        ,params[PFREQ_PARAM].getValue()+inputs[IFREQ_INPUT].getVoltage()
-        ,params[PFREQ_PARAM].getValue()
-      );
-
-    	float freq = dsp::FREQ_C4 * powf(2.0f, pitch);
-    	tStep += args.sampleTime * freq * numSegments;
-    	int arrIdx = floor(tStep);
-    	float t = tStep - arrIdx;
-
-      if (morphStep == 0){
-        int modus = params[STYLE_PARAM].getValue();
-        if (modus == 0){bezierTarget = genSmoothSpline();}
-        else if (modus == 1){bezierTarget = genHalfWildSpline();}
-        else if (modus == 2){bezierTarget = genWildSpline();};        
-        morphSteps = params[PMORPH_PARAM].getValue();
-        for (int i = 0; i < 4; i++){
-            morph[i] = (bezierTarget[i] - bezierMorph[i]) / morphSteps;
+    if (restartRequested.exchange(false)){
+      restart();
+    }
+		if(outputs[OUT_OUTPUT].isConnected() || splineTarget(this)){
+      int channels = std::max(1, inputs[IFREQ_INPUT].getChannels());
+      switch (activeSegments){
+        case 2: processSpline(core2, args, channels); break;
+        case 8: processSpline(core8, args, channels); break;
+        case 16: processSpline(core16, args, channels); break;
+        default: processSpline(core4, args, channels); break;
+      }
+      outputs[OUT_OUTPUT].setChannels(channels);
+
+      refillPool();
+    }
+  }
+
+  template <int N>
+  void processSpline(SplineCore<N>& core, const ProcessArgs& args, int channels){
+    int modus = params[STYLE_PARAM].getValue();
+    SplineMessage* message = splineTarget(this);
+    if (!message){
+      publishTarget = -1;
+    }
+    // Voice 2 is the x of the passed spline, it morphs also when it does
+    // not play.
+    int morphing = message ? std::max(channels, 2) : channels;
+
+    for (int c = 0; c < channels; c += 4){
+      int g = c / 4;
+      // Morph done, the target becomes the source of the next one.
+      int done = simd::movemask(morphPos[g] >= 1.f);
+      if (done){
+        for (int l = 0; l < 4 && c + l < morphing; l++){
+          if (done & (1 << l)){
+            newTarget(core, c + l, modus);
+          }
+        }
+      }
+      float_4 e = ease(morphPos[g]);
+      morphPos[g] += args.sampleTime * morphSpeed[g];
+      if (g == 0 && message){
+        publishSpline(core, e, message);
+      }
+
+      float_4 pitch = params[PFREQ_PARAM].getValue();
+      if (inputs[IFREQ_INPUT].isConnected()){
+        pitch += inputs[IFREQ_INPUT].getPolyVoltageSimd<float_4>(c);
+      }
+
+      float_4 freq = dsp::FREQ_C4 * simd::pow(2.0f, pitch);
+      float_4& step = tStep[g];
+      float_4 prevStep = step;
+      step += args.sampleTime * freq * N;
+      float_4 arrIdx = simd::floor(step);
+      float_4 t = step - arrIdx;
+
+      // one complete cycle done
+      float_4 wrap = arrIdx >= N;
+      arrIdx = simd::ifelse(wrap, 0.f, arrIdx);
+      step = simd::ifelse(wrap, t, step);
+
+      float_4 P[4];
+      core.segmentPoints(g, arrIdx, e, P);
+
+      // The points morph every sample, de Casteljau saves the conversion
+      // to power basis.
+      float_4 bez = bezierPoint(P, t);
+
+      if (adaa){
+        // First order ADAA, (F(x1) - F(x0)) / (x1 - x0) over the phase
+        // advanced in this sample, x in segments.
+        float_4 dx = args.sampleTime * freq * N;
+        float_4 prevIdx = simd::floor(prevStep);
+        float_4 prevT = prevStep - prevIdx;
+        float_4 crossed = prevIdx != arrIdx;
+        // Rest of the previous segment, exact, its points are only 
+        // picked when a lane has crossed a boundary.
+        float_4 from = -bezierIntegral(P, prevT);
+        if (simd::movemask(crossed)){
+          float_4 Q[4];
+          core.segmentPoints(g, prevIdx, e, Q);
+          float_4 rest = (Q[0] + Q[1] + Q[2] + Q[3]) * 0.25f - bezierIntegral(Q, prevT);
+          from = simd::ifelse(crossed, rest, from);
+        }
+        float_4 aa = (from + bezierIntegral(P, t)) / dx;
+        // Ill conditioned for small steps, no aliasing to remove there. 
+        // More than a segment per sample is not band limited anyway. These
+        // lanes take the curve at the middle of the step, half a sample 
+        // late like the ADAA.
+        float_4 valid = (dx > 1e-3f) & (dx < 1.f);
+        if (simd::movemask(valid) != 0xf){
+          float_4 mid = prevStep + 0.5f * dx;
+          float_4 midIdx = simd::floor(mid);
+          float_4 midT = mid - midIdx;
+          midIdx -= N * simd::floor(midIdx / N);
+          float_4 mb;
+          if (simd::movemask((midIdx != arrIdx) & ~valid)){
+            float_4 M[4];
+            core.segmentPoints(g, midIdx, e, M);
+            mb = bezierPoint(M, midT);
+          } else {
+            mb = bezierPoint(P, midT);
+          }
+          aa = simd::ifelse(valid, aa, mb);
         }
+        bez = aa;
       }
+      outputs[OUT_OUTPUT].setVoltageSimd(bez, c);
+    }
+  }
 
-    	if (arrIdx >= numSegments){ // one complete cycle done
-    	  arrIdx = 0;
-    	  tStep = t;
-        tSteps = 0;
-      } 
-
-    	float t2 = t * t;
-    	float t3 = t2 * t;
-    	float tm = 1 - t;
-    	float tm2 = tm * tm;
-    	float tm3 = tm2 * tm;
-      float tm2t_3 = 3*tm2*t;
-      float tmt2_3 = 3*tm*t2;
-      float b1 = (bezierMorph[arrIdx][0])*tm3;
-      float b2 = (bezierMorph[arrIdx][1])*tm2t_3;
-      float b3 = (bezierMorph[arrIdx][2])*tmt2_3;
-      float b4 = (bezierMorph[arrIdx][3])*t3;
-      float bez = b1+b2+b3+b4;
-
-      for (int i = 0; i < numSegments; i++){
-          bezierMorph[i] += morph[i];
+  /** Passes the morphed spline to a following Bezosc on the right, voice 1
+      as y and voice 2 as x, every sample it changed. Two segments are split
+      in half, 8 and 16 are fitted by least squares, N / 4 segments to one,
+      through every N / 4-th knot.
+  */
+  template <int N>
+  void publishSpline(const SplineCore<N>& core, float_4 e, SplineMessage* message){
+    if (
+         e[0] == publishedEase[0] && e[1] == publishedEase[1]
+      && rightExpander.moduleId == publishTarget
+    ){
+      return;
+    }
+    publishedEase[0] = e[0];
+    publishedEase[1] = e[1];
+    publishTarget = rightExpander.moduleId;
+    const int n = SplineMessage::numSegments;
+    float_4 P[N][4];
+    for (int s = 0; s < N; s++){
+      for (int j = 0; j < 4; j++){
+        P[s][j] = core.source[0][s][j] + core.delta[0][s][j] * e;
       }
+    }
+    float_4 Q[n][4];
+    for (int s = 0; s < n; s++){
+      if (N < n){
+        float_4 L[4];
+        float_4 R[4];
+        bezierSplit(P[s / 2], 0.5f, L, R);
+        for (int j = 0; j < 4; j++){
+          Q[s][j] = (s % 2) ? R[j] : L[j];
+        }
+      }
+      else if (N == n){
+        for (int j = 0; j < 4; j++){
+          Q[s][j] = P[s][j];
+        }
+      }
+      else {
+        bezierFit(&P[s * N / n], N / n, Q[s]);
+      }
+    }
+    for (int s = 0; s < n; s++){
+      for (int j = 0; j < 4; j++){
+        message->x[s][j] = Q[s][j][1];
+        message->y[s][j] = Q[s][j][0];
+      }
+    }
+    // 0 is no spline yet.
+    if (++publishSerial == 0){
+      publishSerial = 1;
+    }
+    message->serial = publishSerial;
+    splineFlip(this);
+  }
 
-      if (morphStep++ >= morphSteps){
-        morphStep = 0;
+  json_t* dataToJson() override {
+    json_t* rootJ = json_object();
+    json_object_set_new(rootJ, "seed", json_integer((json_int_t) pendingSeed.load()));
+    json_object_set_new(rootJ, "easing", json_integer(easing));
+    json_object_set_new(rootJ, "adaa", json_boolean(adaa));
+    json_object_set_new(rootJ, "segments", json_integer(pendingSegments.load()));
+    return rootJ;
+  }
+
+  // Old patches have no data, dataFromJson is not called for them.
+  void fromJson(json_t* rootJ) override {
+    Module::fromJson(rootJ);
+    convertLegacyMorph();
+  }
+
+  void dataFromJson(json_t* rootJ) override {
+    json_t* seedJ = json_object_get(rootJ, "seed");
+    if (seedJ){
+      pendingSeed = (uint64_t) json_integer_value(seedJ);
+      restartRequested = true;
+    }
+    json_t* easingJ = json_object_get(rootJ, "easing");
+    if (easingJ){
+      easing = clamp((int) json_integer_value(easingJ), 0, NUM_EASINGS - 1);
+    }
+    json_t* adaaJ = json_object_get(rootJ, "adaa");
+    if (adaaJ){
+      adaa = json_is_true(adaaJ);
+    }
+    json_t* segmentsJ = json_object_get(rootJ, "segments");
+    if (segmentsJ){
+      int n = json_integer_value(segmentsJ);
+      if (n == 2 || n == 4 || n == 8 || n == 16){
+        pendingSegments = n;
+        restartRequested = true;
       }
-      tSteps++;
-			outputs[OUT_OUTPUT].setVoltage(bez);
     }
   }
 };
@@ -160,7 +425,7 @@ struct RndbezoscWidget : ModuleWidget {
 		addChild(createWidget<ScrewSilver>(Vec(0, 0)));
 		addChild(createWidget<ScrewSilver>(Vec(box.size.x - 1 * RACK_GRID_WIDTH, RACK_GRID_HEIGHT - RACK_GRID_WIDTH)));
 
-    addParam(createParamCentered<GreenKnob>(mm2px(Vec(15.037, 36.238)), module, Rndbezosc::PMORPH_PARAM));
+    addParam(createParamCentered<GreenKnob>(mm2px(Vec(15.037, 36.238)), module, Rndbezosc::MORPHTIME_PARAM));
     addParam(createParamCentered<ModusThree>(mm2px(Vec(20.473, 66.338)), module, Rndbezosc::STYLE_PARAM));
 		addParam(createParamCentered<HugeGreenKnob>(mm2px(Vec(12.693, 94.771)), module, Rndbezosc::PFREQ_PARAM));
 
@@ -168,6 +433,74 @@ struct RndbezoscWidget : ModuleWidget {
 
 		addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(5.078, 16.06)), module, Rndbezosc::OUT_OUTPUT));
 	}
+
+  struct NewSeedItem : MenuItem {
+    Rndbezosc* module;
+    void onAction(const event::Action& e) override {
+      module->pendingSeed = random::u64();
+      module->restartRequested = true;
+    }
+  };
+
+  struct EasingItem : MenuItem {
+    Rndbezosc* module;
+    int easing;
+    void onAction(const event::Action& e) override {
+      module->easing = easing;
+    }
+  };
+
+  struct AdaaItem : MenuItem {
+    Rndbezosc* module;
+    void onAction(const event::Action& e) override {
+      module->adaa ^= true;
+    }
+  };
+
+  struct SegmentsItem : MenuItem {
+    Rndbezosc* module;
+    int segments;
+    void onAction(const event::Action& e) override {
+      module->pendingSegments = segments;
+      module->restartRequested = true;
+    }
+  };
+
+  void appendContextMenu(Menu* menu) override {
+    Rndbezosc* module = dynamic_cast<Rndbezosc*>(this->module);
+
+    menu->addChild(new MenuSeparator);
+    menu->addChild(createMenuLabel("Segments"));
+    for (int n = 2; n <= Rndbezosc::maxSegments; n *= 2){
+      SegmentsItem* segmentsItem = createMenuItem<SegmentsItem>(std::to_string(n), CHECKMARK(module->pendingSegments == n));
+      segmentsItem->module = module;
+      segmentsItem->segments = n;
+      menu->addChild(segmentsItem);
+    }
+
+    menu->addChild(new MenuSeparator);
+    AdaaItem* adaaItem = createMenuItem<AdaaItem>("Anti-aliasing (ADAA)", CHECKMARK(module->adaa));
+    adaaItem->module = module;
+    menu->addChild(adaaItem);
+
+    menu->addChild(new MenuSeparator);
+    menu->addChild(createMenuLabel("Morph easing"));
+    const char* easings[] = {"Linear", "Smoothstep", "Exponential"};
+    for (int i = 0; i < Rndbezosc::NUM_EASINGS; i++){
+      EasingItem* easingItem = createMenuItem<EasingItem>(easings[i], CHECKMARK(module->easing == i));
+      easingItem->module = module;
+      easingItem->easing = i;
+      menu->addChild(easingItem);
+    }
+
+    menu->addChild(new MenuSeparator);
+    char seed[32];
+    snprintf(seed, sizeof(seed), "Seed %016llx", (unsigned long long) module->pendingSeed.load());
+    menu->addChild(createMenuLabel(seed));
+    NewSeedItem* item = createMenuItem<NewSeedItem>("New seed");
+    item->module = module;
+    menu->addChild(item);
+  }
 };
 
 Model* modelRndbezosc = createModel<Rndbezosc, RndbezoscWidget>("rndbezosc");
\ No newline at end of file
@@ -0,0 +1,147 @@
+#pragma once
+#include <rack.hpp>
+
+using namespace rack;
+
+/** Closed random 1D Bezier spline of N cubic segments, four voices per
+  float_4, [group][segment][point]. The spline morphs from source to target,
+  delta is target - source, evaluated as source + delta * ease for the
+  points of the segment being played only.
+  N is a compile time constant, the loops over segments and points unroll
+  and the per sample cost does not depend on N.
+*/
+template <int N>
+struct SplineCore {
+  static const int numSegments = N;
+  static const int pointsSegment = 4;
+  /** Uniforms one target takes, the wild style uses them all. */
+  static const int numUniforms = N * pointsSegment;
+
+  typedef float Spline[N][pointsSegment];
+
+  simd::float_4 source[4][N][pointsSegment] = {};
+  simd::float_4 target[4][N][pointsSegment] = {};
+  simd::float_4 delta[4][N][pointsSegment] = {};
+
+  static float value(float u) {
+    return rescale(u, 0.f, 1.f, -2.5f, 2.5f);
+  }
+
+  /** Segment s starts on the last knot of segment s - 1 with the handle
+      mirrored, continuous in value and slope.
+  */
+  static void join(Spline b, int s) {
+    b[s][0] = b[s - 1][3];
+    b[s][1] = b[s - 1][3] - (b[s - 1][2] - b[s - 1][3]);
+  }
+
+  /** The last segment joins and runs into the first knot, mirrored handle. */
+  static void close(Spline b) {
+    join(b, N - 1);
+    b[N - 1][2] = b[0][0] - (b[0][1] - b[0][0]);
+    b[N - 1][3] = b[0][0];
+  }
+
+  /** First segment random, a random handle and knot for every segment
+      up to the last, smooth all around.
+  */
+  static void genSmooth(const float* u, Spline b) {
+    for (int j = 0; j < pointsSegment; j++) {
+      b[0][j] = value(u[j]);
+    }
+    for (int s = 1; s < N - 1; s++) {
+      join(b, s);
+      b[s][2] = value(u[2 * s + 2]);
+      b[s][3] = value(u[2 * s + 3]);
+    }
+    close(b);
+  }
+
+  /** First half random, the second half smooth, the handle on the knot. */
+  static void genHalfWild(const float* u, Spline b) {
+    for (int s = 0; s < N / 2; s++) {
+      for (int j = 0; j < pointsSegment; j++) {
+        b[s][j] = value(u[s * pointsSegment + j]);
+      }
+    }
+    for (int s = N / 2; s < N - 1; s++) {
+      join(b, s);
+      b[s][2] = value(u[2 * N + s - N / 2]);
+      b[s][3] = b[s][2];
+    }
+    close(b);
+  }
+
+  /** Every point random. */
+  static void genWild(const float* u, Spline b) {
+    for (int s = 0; s < N; s++) {
+      for (int j = 0; j < pointsSegment; j++) {
+        b[s][j] = value(u[s * pointsSegment + j]);
+      }
+    }
+  }
+
+  static void generate(int modus, const float* u, Spline b) {
+    if (modus == 1) {
+      genHalfWild(u, b);
+    }
+    else if (modus == 2) {
+      genWild(u, b);
+    }
+    else {
+      genSmooth(u, b);
+    }
+  }
+
+  /** Sets the target of voice v directly, no morph. */
+  void setTarget(int v, int modus, const float* u) {
+    Spline b;
+    generate(modus, u, b);
+    for (int s = 0; s < N; s++) {
+      for (int j = 0; j < pointsSegment; j++) {
+        target[v / 4][s][j][v % 4] = b[s][j];
+      }
+    }
+  }
+
+  /** The last target of voice v becomes the source of a morph to a new one. */
+  void newTarget(int v, int modus, const float* u) {
+    int g = v / 4;
+    int l = v % 4;
+    for (int s = 0; s < N; s++) {
+      for (int j = 0; j < pointsSegment; j++) {
+        source[g][s][j][l] = target[g][s][j][l];
+      }
+    }
+    setTarget(v, modus, u);
+    for (int s = 0; s < N; s++) {
+      for (int j = 0; j < pointsSegment; j++) {
+        delta[g][s][j][l] = target[g][s][j][l] - source[g][s][j][l];
+      }
+    }
+  }
+
+  /** Morphed points of the segment every lane is on. Lanes on different
+      segments are gathered, the cost does not grow with N.
+  */
+  void segmentPoints(int g, simd::float_4 idx, simd::float_4 e, simd::float_4* P) const {
+    int seg = idx[0];
+    if (simd::movemask(idx == seg) == 0xf) {
+      for (int j = 0; j < pointsSegment; j++) {
+        P[j] = source[g][seg][j] + delta[g][seg][j] * e;
+      }
+      return;
+    }
+    simd::float_4 D[pointsSegment];
+    for (int l = 0; l < 4; l++) {
+      int s = idx[l];
+      for (int j = 0; j < pointsSegment; j++) {
+        P[j][l] = source[g][s][j][l];
+        D[j][l] = delta[g][s][j][l];
+      }
+    }
+    for (int j = 0; j < pointsSegment; j++) {
+      P[j] += D[j] * e;
+    }
+  }
+};
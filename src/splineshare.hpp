@@ -0,0 +1,53 @@
+#pragma once
+#include "plugin.hpp"
+#include <atomic>
+
+/** Shape a Bezosc or Rndbezosc passes to the Bezosc on its right through
+  the expander messages, the control points of a closed spline of four
+  cubic segments, [segment][point], 32 floats. The consumer owns both
+  buffers of its left expander. The producer writes into the producer
+  message only when the shape changed, counts the serial up and requests
+  the flip, the engine swaps the buffers after the step and the consumer
+  reads the consumer message one sample later. The consumer sets follows
+  in both buffers, a producer passes nothing to a Bezosc that does not
+  follow.
+*/
+struct SplineMessage {
+  static const int numSegments = 4;
+  static const int pointsSegment = 4;
+  float x[numSegments][pointsSegment] = {};
+  float y[numSegments][pointsSegment] = {};
+  // 0 until the first shape arrives.
+  uint32_t serial = 0;
+  // Written by the consumer only, read by the producer.
+  std::atomic<bool> follows {false};
+};
+
+/** Producer message of the Bezosc right of m, NULL if there is none or
+  it does not follow its left neighbour.
+*/
+inline SplineMessage* splineTarget(Module* m) {
+  Module* right = m->rightExpander.module;
+  if (!right || right->model != modelBezosc) {
+    return NULL;
+  }
+  SplineMessage* message = (SplineMessage*) right->leftExpander.producerMessage;
+  return message->follows.load(std::memory_order_relaxed) ? message : NULL;
+}
+
+/** Hands the message written by m to its right neighbour, on the next sample. */
+inline void splineFlip(Module* m) {
+  m->rightExpander.module->leftExpander.messageFlipRequested = true;
+}
+
+/** Consumer message of m from the module on its left, NULL if that is
+  not a Bezosc or Rndbezosc or has not passed a spline yet.
+*/
+inline const SplineMessage* splineSource(Module* m) {
+  Module* left = m->leftExpander.module;
+  if (!left || (left->model != modelBezosc && left->model != modelRndbezosc)) {
+    return NULL;
+  }
+  const SplineMessage* message = (const SplineMessage*) m->leftExpander.consumerMessage;
+  return message->serial ? message : NULL;
+}
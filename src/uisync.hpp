@@ -0,0 +1,109 @@
+#pragma once
+#include <rack.hpp>
+#include <cmath>
+
+using namespace rack;
+
+/** Control-rate clock for everything only the UI reads.
+  The UI redraws at about 60 Hz, there is no point in writing lights or
+  derived params at audio rate.
+*/
+struct UiClock {
+  static constexpr float defaultRate = 60.f;
+
+  dsp::ClockDivider divider;
+  float rate = defaultRate;
+  float sampleRate = 0.f;
+
+  void setRate(float rate) {
+    this->rate = rate;
+    sampleRate = 0.f;
+  }
+
+  /** Call once per sample, true once per UI period. */
+  bool process(float sampleRate) {
+    if (sampleRate != this->sampleRate) {
+      this->sampleRate = sampleRate;
+      divider.setDivision(std::max(1, (int) (sampleRate / rate)));
+    }
+    return divider.process();
+  }
+
+  json_t* toJson() {
+    return json_real(rate);
+  }
+
+  void fromJson(json_t* rateJ) {
+    if (rateJ) {
+      setRate(clamp((float) json_number_value(rateJ), 1.f, 1000.f));
+    }
+  }
+};
+
+/** N values staged by the audio thread, plain stores, and written through
+  on the UI clock. Only values that changed since the last flush are written,
+  values never staged are left alone.
+*/
+template <int N>
+struct UiValues {
+  float staged[N];
+  float written[N];
+
+  UiValues() {
+    for (int i = 0; i < N; i++) {
+      staged[i] = NAN;
+      written[i] = NAN;
+    }
+  }
+
+  void set(int i, float v) {
+    staged[i] = v;
+  }
+
+  /** Stages v[0..3] at i..i+3 where mask is set. */
+  void set(int i, simd::float_4 v, simd::float_4 mask) {
+    simd::float_4 old = simd::float_4::load(&staged[i]);
+    simd::ifelse(mask, v, old).store(&staged[i]);
+  }
+
+  /** Writes every staged value again on the next flush. */
+  void invalidate() {
+    for (int i = 0; i < N; i++) {
+      written[i] = NAN;
+    }
+  }
+
+  /** Calls write(i, value) for every staged value that changed. */
+  template <typename F>
+  void flush(F write) {
+    for (int i = 0; i < N; i++) {
+      if (!std::isnan(staged[i]) && staged[i] != written[i]) {
+        write(i, staged[i]);
+        written[i] = staged[i];
+      }
+    }
+  }
+};
+
+struct UiRateItem : MenuItem {
+  UiClock* clock;
+  float rate;
+  void onAction(const event::Action& e) override {
+    clock->setRate(rate);
+  }
+};
+
+/** Context menu section to pick the UI rate. */
+inline void appendUiRateMenu(Menu* menu, UiClock* clock) {
+  menu->addChild(new MenuSeparator);
+  menu->addChild(createMenuLabel("UI rate"));
+  const int rates[] = {15, 30, 60, 120};
+  for (int rate : rates) {
+    UiRateItem* item = createMenuItem<UiRateItem>(
+      std::to_string(rate) + " Hz", CHECKMARK(clock->rate == rate)
+    );
+    item->clock = clock;
+    item->rate = rate;
+    menu->addChild(item);
+  }
+}
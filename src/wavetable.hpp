@@ -0,0 +1,74 @@
+#pragma once
+#include <rack.hpp>
+#include <cstring>
+
+using namespace rack;
+
+/** One cycle wavetable, band-limited and mip-mapped.
+  Level l keeps the harmonics up to (size / 2) >> l, the last level is a
+  plain sine of the fundamental. Each level carries a guard point so
+  playback can interpolate without wrapping the index.
+*/
+struct MipMapTable {
+  static const int size = 1024;
+  static const int levels = 10;
+
+  float data[levels][size + 1];
+
+  /** Level holding no harmonics above Nyquist for the given frequency. */
+  static int level(float freq, float sampleTime) {
+    // Harmonics of level 0 reach size / 2, every level halves them.
+    float ratio = freq * sampleTime * size;
+    if (ratio <= 1.f) {
+      return 0;
+    }
+    int e;
+    float m = std::frexp(ratio, &e);
+    int l = (m == 0.5f) ? e - 1 : e;
+    return std::min(l, levels - 1);
+  }
+
+  /** Linear interpolated read, phase in [0, 1). */
+  float read(int l, float phase) const {
+    float p = phase * size;
+    int i = std::min((int) p, size - 1);
+    float frac = p - i;
+    const float* d = data[l];
+    return d[i] + (d[i + 1] - d[i]) * frac;
+  }
+};
+
+/** Renders a MipMapTable from one cycle, owns the FFT and its aligned buffers.
+  Meant to run off the audio thread.
+*/
+struct MipMapBaker {
+  static const int size = MipMapTable::size;
+
+  dsp::RealFFT fft;
+  alignas(16) float cycle[size];
+  alignas(16) float spectrum[size];
+  alignas(16) float band[size];
+  alignas(16) float wave[size];
+
+  MipMapBaker() : fft(size) {}
+
+  /** Band-limits the cycle buffer into all levels of table. */
+  void bake(MipMapTable& table) {
+    fft.rfft(cycle, spectrum);
+    for (int l = 0; l < MipMapTable::levels; l++) {
+      int maxHarmonic = (size / 2) >> l;
+      std::memcpy(band, spectrum, sizeof(band));
+      if (maxHarmonic < size / 2) {
+        band[1] = 0.f; // Nyquist
+        for (int k = maxHarmonic + 1; k < size / 2; k++) {
+          band[2 * k] = 0.f;
+          band[2 * k + 1] = 0.f;
+        }
+      }
+      fft.irfft(band, wave);
+      fft.scale(wave);
+      std::memcpy(table.data[l], wave, sizeof(wave));
+      table.data[l][size] = table.data[l][0];
+    }
+  }
+};
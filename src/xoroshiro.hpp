@@ -0,0 +1,41 @@
+#pragma once
+#include <rack.hpp>
+
+using namespace rack;
+
+/** xoroshiro128+ by Blackman and Vigna, seeded through splitmix64.
+  One instance per module, the same seed gives the same sequence on every
+  machine.
+*/
+struct Xoroshiro128Plus {
+  uint64_t state[2] = {};
+
+  void seed(uint64_t s) {
+    for (int i = 0; i < 2; i++) {
+      s += 0x9e3779b97f4a7c15ULL;
+      uint64_t z = s;
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+      state[i] = z ^ (z >> 31);
+    }
+  }
+
+  static uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+  }
+
+  uint64_t next() {
+    uint64_t s0 = state[0];
+    uint64_t s1 = state[1];
+    uint64_t result = s0 + s1;
+    s1 ^= s0;
+    state[0] = rotl(s0, 24) ^ s1 ^ (s1 << 16);
+    state[1] = rotl(s1, 37);
+    return result;
+  }
+
+  /** Uniform in [0, 1), from the upper 24 bits. */
+  float uniform() {
+    return (next() >> 40) * (1.f / 16777216.f);
+  }
+};